@@ -0,0 +1,125 @@
+/*! \file decompose_throughput.cpp
+  \brief Measures the throughput of the decompose.h array functions.
+  Every kernel runs over the same set of matrices, once for well conditioned
+  inputs and once for nearly singular ones (condition number around 1e4):
+  \code
+  g++ -std=c++17 -O2 -Isrc src/[a-z]*.cpp bench/decompose_throughput.cpp -o decompose_throughput -pthread
+  \endcode
+  Results are in bench/README.txt.
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+#include "vec.h"
+#include "matrix.h"
+#include "decompose.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const size_t MATRICES = 4096;
+    const int PASSES = 50;
+    const int RUNS = 5;
+
+    // Deterministic values in [-1, 1], the same on every platform
+    float NextValue(uint32_t &state)
+    {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<float>(state >> 8) / 8388608.0f - 1.0f;
+    }
+
+    // Fills matrices with random 3x3 parts, nearlySingular makes the third row almost a combination of the others
+    void Generate(vector<Mat4> &matrices, bool nearlySingular)
+    {
+        uint32_t state = 12345;
+        for(size_t n = 0; n < matrices.size(); n++)
+        {
+            Mat4 &matrix = matrices[n];
+            matrix.SetIdentity();
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    matrix.m[i][j] = (i == j ? 2.0f : 0.0f) + NextValue(state);
+                }
+            }
+            if(nearlySingular)
+            {
+                float a = NextValue(state);
+                float b = NextValue(state);
+                for(int j = 0; j < 3; j++)
+                {
+                    matrix.m[2][j] = a * matrix.m[0][j] + b * matrix.m[1][j] + 1e-4f * NextValue(state);
+                }
+            }
+        }
+    }
+
+    // Returns the best of RUNS timings in nanoseconds per matrix
+    template<class Function> double Measure(Function function)
+    {
+        double best = 1e30;
+        for(int run = 0; run < RUNS; run++)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            for(int pass = 0; pass < PASSES; pass++)
+            {
+                function();
+            }
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best = seconds < best ? seconds : best;
+        }
+        return best * 1e9 / (double(PASSES) * MATRICES);
+    }
+}
+
+int main()
+{
+    vector<Mat4> matrices(MATRICES), symmetric(MATRICES), first(MATRICES), second(MATRICES);
+    vector<Vec3f> vectors(MATRICES), translations(MATRICES);
+    vector<int[4]> pivots(MATRICES);
+    size_t failed = 0;
+
+    for(int set = 0; set < 2; set++)
+    {
+        Generate(matrices, set == 1);
+        for(size_t n = 0; n < MATRICES; n++)
+        {
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    symmetric[n].m[i][j] = 0.5f * matrices[n].m[i][j] + 0.5f * matrices[n].m[j][i];
+                }
+            }
+        }
+
+        double qr = Measure([&]() { failed += DecomposeQR(matrices.data(), first.data(), second.data(), MATRICES); });
+        double polar = Measure([&]() { failed += DecomposePolar(matrices.data(), first.data(), second.data(), MATRICES); });
+        double eigen = Measure([&]() { EigenSymmetric3x3(symmetric.data(), vectors.data(), first.data(), MATRICES); });
+        double transform = Measure([&]() {
+            failed += DecomposeTransform(matrices.data(), translations.data(), first.data(), vectors.data(), MATRICES);
+        });
+        // DecomposeLU works in place, the copy of the input is part of its time
+        double lu = Measure([&]() {
+            first = matrices;
+            failed += DecomposeLU(first.data(), pivots.data(), MATRICES);
+        });
+        double solve = Measure([&]() {
+            for(size_t n = 0; n < MATRICES; n++)
+            {
+                vectors[n] = Vec3f(1.0f, 2.0f, 3.0f);
+            }
+            failed += Solve3x3(matrices.data(), vectors.data(), MATRICES);
+        });
+
+        printf("%s: DecomposeQR %.1f, DecomposePolar %.1f, EigenSymmetric3x3 %.1f, DecomposeTransform %.1f, DecomposeLU %.1f, Solve3x3 %.1f ns per matrix\n",
+                set == 0 ? "well conditioned" : "nearly singular", qr, polar, eigen, transform, lu, solve);
+    }
+    printf("failed decompositions %zu\n", failed);
+    return 0;
+}
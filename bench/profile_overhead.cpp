@@ -0,0 +1,74 @@
+/*! \file profile_overhead.cpp
+  \brief Measures the cost of the MATHLIB_PROFILE counters on single-element kernels.
+  Build once without and once with profiling and compare the times:
+  \code
+  g++ -std=c++17 -O2 -Isrc src/[a-z]*.cpp bench/profile_overhead.cpp -o profile_off -pthread
+  g++ -std=c++17 -O2 -DMATHLIB_PROFILE -Isrc src/[a-z]*.cpp bench/profile_overhead.cpp -o profile_on -pthread
+  \endcode
+  Results are in bench/README.txt.
+  */
+
+#include <chrono>
+#include <cstdio>
+#include "vec.h"
+#include "matrix.h"
+#include "functions.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const int CALLS = 20000000;
+    const int RUNS = 5;
+
+    // Returns the best of RUNS timings in seconds
+    template<class Function> double Measure(Function function)
+    {
+        double best = 1e30;
+        for(int run = 0; run < RUNS; run++)
+        {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            function();
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            best = seconds < best ? seconds : best;
+        }
+        return best;
+    }
+}
+
+int main()
+{
+    Mat4 matrix;
+    Mat4 step;
+    MatrixRotationY(matrix, 0.5f);
+    MatrixRotationX(step, 1e-7f);
+    Vec3f point(1.0f, 2.0f, 3.0f);
+    float checksum = 0.0f;
+
+    double transform = Measure([&]() {
+        Vec3f v = point;
+        for(int i = 0; i < CALLS; i++)
+        {
+            v.Transform(matrix);
+        }
+        checksum += v.x;
+    });
+
+    double multiply = Measure([&]() {
+        Mat4 product = matrix;
+        for(int i = 0; i < CALLS; i++)
+        {
+            product = product * step;
+        }
+        checksum += product.data._11;
+    });
+
+#ifdef MATHLIB_PROFILE
+    const char *mode = "profiled";
+#else
+    const char *mode = "plain";
+#endif
+    printf("%s: Vec3::Transform %.3f s, Mat4::operator * %.3f s per %d calls (checksum %g)\n", mode, transform, multiply, CALLS, checksum);
+    return 0;
+}
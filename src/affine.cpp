@@ -0,0 +1,237 @@
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include "affine.h"
+#include "profiler.h"
+
+using namespace MathLib;
+
+Affine3x4::Affine3x4()
+{
+    memset(&this->m, 0, 12 * sizeof(float));
+}
+
+Affine3x4::Affine3x4(float _11, float _12, float _13,
+        float _21, float _22, float _23,
+        float _31, float _32, float _33,
+        float _41, float _42, float _43)
+{
+    this->data._11 = _11;
+    this->data._12 = _12;
+    this->data._13 = _13;
+    this->data._21 = _21;
+    this->data._22 = _22;
+    this->data._23 = _23;
+    this->data._31 = _31;
+    this->data._32 = _32;
+    this->data._33 = _33;
+    this->data._41 = _41;
+    this->data._42 = _42;
+    this->data._43 = _43;
+}
+
+Affine3x4::Affine3x4(const Mat4 &matrix)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            this->m[i][j] = matrix.m[i][j];
+        }
+    }
+}
+
+Affine3x4 Affine3x4::operator *(const Affine3x4 &matrix) const
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_AFFINE_MULTIPLY);
+    Affine3x4 result;
+
+    result.data._11 = this->data._11 * matrix.data._11 + this->data._21 * matrix.data._12 + this->data._31 * matrix.data._13;
+    result.data._12 = this->data._12 * matrix.data._11 + this->data._22 * matrix.data._12 + this->data._32 * matrix.data._13;
+    result.data._13 = this->data._13 * matrix.data._11 + this->data._23 * matrix.data._12 + this->data._33 * matrix.data._13;
+
+    result.data._21 = this->data._11 * matrix.data._21 + this->data._21 * matrix.data._22 + this->data._31 * matrix.data._23;
+    result.data._22 = this->data._12 * matrix.data._21 + this->data._22 * matrix.data._22 + this->data._32 * matrix.data._23;
+    result.data._23 = this->data._13 * matrix.data._21 + this->data._23 * matrix.data._22 + this->data._33 * matrix.data._23;
+
+    result.data._31 = this->data._11 * matrix.data._31 + this->data._21 * matrix.data._32 + this->data._31 * matrix.data._33;
+    result.data._32 = this->data._12 * matrix.data._31 + this->data._22 * matrix.data._32 + this->data._32 * matrix.data._33;
+    result.data._33 = this->data._13 * matrix.data._31 + this->data._23 * matrix.data._32 + this->data._33 * matrix.data._33;
+
+    result.data._41 = this->data._11 * matrix.data._41 + this->data._21 * matrix.data._42 + this->data._31 * matrix.data._43 + this->data._41;
+    result.data._42 = this->data._12 * matrix.data._41 + this->data._22 * matrix.data._42 + this->data._32 * matrix.data._43 + this->data._42;
+    result.data._43 = this->data._13 * matrix.data._41 + this->data._23 * matrix.data._42 + this->data._33 * matrix.data._43 + this->data._43;
+
+    return result;
+}
+
+Mat4 Affine3x4::operator *(const Mat4 &matrix) const
+{
+    Mat4 result;
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            result.m[i][j] = matrix.m[i][0] * this->m[0][j] + matrix.m[i][1] * this->m[1][j] + matrix.m[i][2] * this->m[2][j] + matrix.m[i][3] * this->m[3][j];
+        }
+        result.m[i][3] = matrix.m[i][3];
+    }
+    return result;
+}
+
+Mat4 MathLib::operator *(const Mat4 &left, const Affine3x4 &right)
+{
+    Mat4 result;
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            result.m[i][j] = right.m[i][0] * left.m[0][j] + right.m[i][1] * left.m[1][j] + right.m[i][2] * left.m[2][j];
+        }
+    }
+    for(int j = 0; j < 4; j++)
+    {
+        result.m[3][j] += left.m[3][j];
+    }
+    return result;
+}
+
+bool Affine3x4::IsIdentity() const
+{
+    return (data._11 == 1.0f && data._22 == 1.0f && data._33 == 1.0f &&
+            data._12 == 0.0f && data._13 == 0.0f &&
+            data._21 == 0.0f && data._23 == 0.0f &&
+            data._31 == 0.0f && data._32 == 0.0f &&
+            data._41 == 0.0f && data._42 == 0.0f && data._43 == 0.0f);
+}
+
+void Affine3x4::SetIdentity()
+{
+    data._11 = 1.0f;
+    data._12 = 0.0f;
+    data._13 = 0.0f;
+    data._21 = 0.0f;
+    data._22 = 1.0f;
+    data._23 = 0.0f;
+    data._31 = 0.0f;
+    data._32 = 0.0f;
+    data._33 = 1.0f;
+    data._41 = 0.0f;
+    data._42 = 0.0f;
+    data._43 = 0.0f;
+}
+
+Affine3x4 Affine3x4::Inverted() const
+{
+    float c11 = data._22 * data._33 - data._23 * data._32;
+    float c12 = data._23 * data._31 - data._21 * data._33;
+    float c13 = data._21 * data._32 - data._22 * data._31;
+    float determinant = data._11 * c11 + data._12 * c12 + data._13 * c13;
+    if(determinant == 0.0f || !std::isfinite(determinant))
+    {
+        throw std::domain_error("Matrix is singular.");
+    }
+    float inv = 1.0f / determinant;
+
+    Affine3x4 result;
+    result.data._11 = c11 * inv;
+    result.data._12 = (data._13 * data._32 - data._12 * data._33) * inv;
+    result.data._13 = (data._12 * data._23 - data._13 * data._22) * inv;
+    result.data._21 = c12 * inv;
+    result.data._22 = (data._11 * data._33 - data._13 * data._31) * inv;
+    result.data._23 = (data._13 * data._21 - data._11 * data._23) * inv;
+    result.data._31 = c13 * inv;
+    result.data._32 = (data._12 * data._31 - data._11 * data._32) * inv;
+    result.data._33 = (data._11 * data._22 - data._12 * data._21) * inv;
+
+    result.data._41 = -(data._41 * result.data._11 + data._42 * result.data._21 + data._43 * result.data._31);
+    result.data._42 = -(data._41 * result.data._12 + data._42 * result.data._22 + data._43 * result.data._32);
+    result.data._43 = -(data._41 * result.data._13 + data._42 * result.data._23 + data._43 * result.data._33);
+    return result;
+}
+
+Mat4 Affine3x4::ToMat4() const
+{
+    return Mat4(data._11, data._12, data._13, 0.0f,
+            data._21, data._22, data._23, 0.0f,
+            data._31, data._32, data._33, 0.0f,
+            data._41, data._42, data._43, 1.0f);
+}
+
+Vec3f Affine3x4::TransformPoint(const Vec3f &point) const
+{
+    return Vec3f(point.x * data._11 + point.y * data._21 + point.z * data._31 + data._41,
+            point.x * data._12 + point.y * data._22 + point.z * data._32 + data._42,
+            point.x * data._13 + point.y * data._23 + point.z * data._33 + data._43);
+}
+
+Vec3f Affine3x4::TransformPointAsVec3(const Vec3f &point) const
+{
+    return Vec3f(point.x * data._11 + point.y * data._12 + point.z * data._13 + data._41,
+            point.x * data._21 + point.y * data._22 + point.z * data._23 + data._42,
+            point.x * data._31 + point.y * data._32 + point.z * data._33 + data._43);
+}
+
+Vec3f Affine3x4::TransformVector(const Vec3f &vector) const
+{
+    return Vec3f(vector.x * data._11 + vector.y * data._21 + vector.z * data._31,
+            vector.x * data._12 + vector.y * data._22 + vector.z * data._32,
+            vector.x * data._13 + vector.y * data._23 + vector.z * data._33);
+}
+
+void Affine3x4::TransformPoints(const Vec3f *in, Vec3f *out, size_t count) const
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_AFFINE_TRANSFORM_BATCH, count);
+    const float m11 = data._11, m12 = data._12, m13 = data._13;
+    const float m21 = data._21, m22 = data._22, m23 = data._23;
+    const float m31 = data._31, m32 = data._32, m33 = data._33;
+    const float m41 = data._41, m42 = data._42, m43 = data._43;
+    for(size_t i = 0; i < count; i++)
+    {
+        float x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = x * m11 + y * m21 + z * m31 + m41;
+        out[i].y = x * m12 + y * m22 + z * m32 + m42;
+        out[i].z = x * m13 + y * m23 + z * m33 + m43;
+    }
+}
+
+void Affine3x4::TransformPointsAsVec3(const Vec3f *in, Vec3f *out, size_t count) const
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_AFFINE_TRANSFORM_BATCH, count);
+    const float m11 = data._11, m12 = data._12, m13 = data._13;
+    const float m21 = data._21, m22 = data._22, m23 = data._23;
+    const float m31 = data._31, m32 = data._32, m33 = data._33;
+    const float m41 = data._41, m42 = data._42, m43 = data._43;
+    for(size_t i = 0; i < count; i++)
+    {
+        float x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = x * m11 + y * m12 + z * m13 + m41;
+        out[i].y = x * m21 + y * m22 + z * m23 + m42;
+        out[i].z = x * m31 + y * m32 + z * m33 + m43;
+    }
+}
+
+void Affine3x4::TransformVectors(const Vec3f *in, Vec3f *out, size_t count) const
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_AFFINE_TRANSFORM_BATCH, count);
+    const float m11 = data._11, m12 = data._12, m13 = data._13;
+    const float m21 = data._21, m22 = data._22, m23 = data._23;
+    const float m31 = data._31, m32 = data._32, m33 = data._33;
+    for(size_t i = 0; i < count; i++)
+    {
+        float x = in[i].x, y = in[i].y, z = in[i].z;
+        out[i].x = x * m11 + y * m21 + z * m31;
+        out[i].y = x * m12 + y * m22 + z * m32;
+        out[i].z = x * m13 + y * m23 + z * m33;
+    }
+}
+
+float Affine3x4::GetValue(const int& row, const int& col) const
+{
+    return m[row][col];
+}
+
+const float* Affine3x4::GetPointer() const
+{
+    return &data._11;
+}
@@ -0,0 +1,99 @@
+#ifndef AFFINE3X4_H
+#define AFFINE3X4_H
+
+#include <cstddef>
+#include "matrix.h"
+#include "vec.h"
+
+/*! \file affine.h
+  \brief Contains 3x4 affine Matrix declaration
+  */
+
+namespace MathLib
+{
+    //! 3x4 affine Matrix class
+    /*!
+      Stores the first three columns of a Mat4 whose last column is (0, 0, 0, 1).
+      Multiplication follows Mat4::operator *, so A * B gives the same result as
+      A.ToMat4() * B.ToMat4() while skipping the constant column.
+      Points and vectors are transformed as row vectors (p * M), the translation
+      lives in _41, _42 and _43 just like in Mat4.
+      Vec3::Transform uses the transposed 3x3 part instead (x * _11 + y * _12 + z * _13 + _41),
+      so TransformPoint differs from Vec3f::Transform(ToMat4()) for any rotation.
+      Use TransformPointAsVec3 and TransformPointsAsVec3 where results must match Vec3::Transform.
+      */
+    class Affine3x4
+    {
+        public:
+            union
+            {
+                struct
+                {
+                    float _11, _12, _13;
+                    float _21, _22, _23;
+                    float _31, _32, _33;
+                    float _41, _42, _43;	// translation
+                } data;
+                float m[4][3];
+            };
+
+            /*! Default constructor */
+            Affine3x4();
+
+            /*! Constructor which gets values for matrix fields */
+            Affine3x4(float _11, float _12, float _13,
+                    float _21, float _22, float _23,
+                    float _31, float _32, float _33,
+                    float _41, float _42, float _43);
+
+            /*! Takes the affine part of a 4x4 matrix, _14, _24, _34 and _44 are ignored */
+            explicit Affine3x4(const Mat4 &matrix);
+
+            /*! Multiplies a matrix by another affine matrix */
+            Affine3x4 operator *(const Affine3x4 &matrix) const;
+
+            /*! Multiplies a matrix by a 4x4 matrix, used when a projection is involved */
+            Mat4 operator *(const Mat4 &matrix) const;
+
+            /*! Check if it is an identity matrix */
+            bool IsIdentity() const;
+
+            /*! Set the matrix to the identity */
+            void SetIdentity();
+
+            /*! Returns inverted matrix, throws std::domain_error if the matrix is singular */
+            Affine3x4 Inverted() const;
+
+            /*! Returns the full 4x4 matrix */
+            Mat4 ToMat4() const;
+
+            /*! Transforms a point as a row vector, translation included */
+            Vec3f TransformPoint(const Vec3f &point) const;
+
+            /*! Transforms a point the way Vec3::Transform does, the result equals Vec3f(point).Transform(ToMat4()) */
+            Vec3f TransformPointAsVec3(const Vec3f &point) const;
+
+            /*! Transforms a direction vector, translation ignored */
+            Vec3f TransformVector(const Vec3f &vector) const;
+
+            /*! Transforms an array of points, in and out may be the same array */
+            void TransformPoints(const Vec3f *in, Vec3f *out, size_t count) const;
+
+            /*! Transforms an array of points the way Vec3::Transform does, in and out may be the same array */
+            void TransformPointsAsVec3(const Vec3f *in, Vec3f *out, size_t count) const;
+
+            /*! Transforms an array of direction vectors, in and out may be the same array */
+            void TransformVectors(const Vec3f *in, Vec3f *out, size_t count) const;
+
+            /*! Returns value by a row and a column */
+            float GetValue(const int& row, const int& col) const;
+
+            /*! Returns pointer on the begining of a matrix */
+            const float* GetPointer() const;
+    };
+
+    /*! Multiplies a 4x4 matrix by an affine matrix */
+    Mat4 operator *(const Mat4 &left, const Affine3x4 &right);
+}
+
+#endif
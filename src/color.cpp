@@ -0,0 +1,848 @@
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <stdexcept>
+#include "color.h"
+#include "simd.h"
+#include "profiler.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const size_t ENCODE_INDEX_SIZE = 4096;
+    const size_t MIN_PARALLEL_PIXELS = 1 << 16;
+
+    static_assert(sizeof(Color3f) == 3 * sizeof(float) && sizeof(Color4f) == 4 * sizeof(float), "Color arrays are processed as float arrays");
+
+    inline float Saturate(float value)
+    {
+        // written so that NaN maps to 0
+        return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f;
+    }
+
+    inline uint32_t ToByte(float value)
+    {
+        return static_cast<uint32_t>(Saturate(value) * 255.0f + 0.5f);
+    }
+
+    // Byte of a value in [0, 1] encoded with the exact curve, which the encode table reproduces
+    inline uint32_t EncodeByte(float value)
+    {
+        return static_cast<uint32_t>(MathLib::LinearToSrgb(value) * 255.0f + 0.5f);
+    }
+
+    /* Returns the smallest value in [0, 1] whose encoded byte is at least byte. EncodeByte does not
+       decrease on [0, 1], and positive floats are ordered like their bit patterns, so the bits are bisected */
+    float FindEncodeThreshold(uint32_t byte)
+    {
+        const float one = 1.0f;
+        uint32_t low = 0, high;
+        memcpy(&high, &one, sizeof(high));
+        while(low < high)
+        {
+            uint32_t middle = low + (high - low) / 2;
+            float value;
+            memcpy(&value, &middle, sizeof(value));
+            if(EncodeByte(value) >= byte)
+            {
+                high = middle;
+            }
+            else
+            {
+                low = middle + 1;
+            }
+        }
+        float threshold;
+        memcpy(&threshold, &low, sizeof(threshold));
+        return threshold;
+    }
+
+    //! Lookup tables for packed sRGB conversions
+    struct SrgbTables
+    {
+        float decode[256];
+        float encode[257];	// encode[k] is the smallest linear value encoded to byte k or above, encode[256] ends the table
+        unsigned char encodeIndex[ENCODE_INDEX_SIZE];	// byte of the nearest grid point, at most one away from the exact byte
+
+        SrgbTables()
+        {
+            for(int i = 0; i < 256; i++)
+            {
+                decode[i] = MathLib::SrgbToLinear(i / 255.0f);
+            }
+            encode[0] = 0.0f;
+            for(uint32_t k = 1; k < 256; k++)
+            {
+                encode[k] = FindEncodeThreshold(k);
+            }
+            encode[256] = INFINITY;
+            for(size_t i = 0; i < ENCODE_INDEX_SIZE; i++)
+            {
+                encodeIndex[i] = static_cast<unsigned char>(EncodeByte(i / float(ENCODE_INDEX_SIZE - 1)));
+            }
+        }
+    };
+
+    const SrgbTables& GetSrgbTables()
+    {
+        static const SrgbTables tables;
+        return tables;
+    }
+
+    /* Gives EncodeByte(Saturate(value)). The curve rises by less than a byte between grid points, so the byte
+       of the nearest grid point is corrected by comparing with the thresholds next to it */
+    inline uint32_t ToSrgbByte(const SrgbTables &tables, float value)
+    {
+        float saturated = Saturate(value);
+        uint32_t index = tables.encodeIndex[static_cast<size_t>(saturated * (ENCODE_INDEX_SIZE - 1) + 0.5f)];
+        index -= saturated < tables.encode[index] ? 1 : 0;
+        index += saturated >= tables.encode[index + 1] ? 1 : 0;
+        return index;
+    }
+
+    // Coefficients of log2(m) = 2 / ln(2) * atanh((m - 1) / (m + 1)) for m in [sqrt(1/2), sqrt(2))
+    const float LOG2_C1 = 2.88539008f;
+    const float LOG2_C3 = 0.961796694f;
+    const float LOG2_C5 = 0.577078016f;
+    const float LOG2_C7 = 0.412198583f;
+
+    // Taylor coefficients of 2^f = e^(f * ln(2)) for f in [-0.5, 0.5]
+    const float EXP2_C1 = 0.693147181f;
+    const float EXP2_C2 = 0.240226507f;
+    const float EXP2_C3 = 0.0555041087f;
+    const float EXP2_C4 = 0.00961812911f;
+    const float EXP2_C5 = 0.00133335581f;
+    const float EXP2_C6 = 0.000154035304f;
+    const float EXP2_C7 = 1.52527338e-05f;
+
+    const float SRGB_DECODE_KNEE = 0.04045f;
+    const float SRGB_ENCODE_KNEE = 0.0031308f;
+
+    // Relative error of Pow is about 1e-6 for positive normal inputs, the scalar and
+    // SSE versions execute the same operations and give the same results
+    inline float Log2(float x)
+    {
+        uint32_t bits;
+        memcpy(&bits, &x, sizeof(bits));
+        float exponent = static_cast<float>(static_cast<int>((bits >> 23) & 0xff) - 127);
+        bits = (bits & 0x007fffff) | 0x3f800000;
+        float mantissa;
+        memcpy(&mantissa, &bits, sizeof(mantissa));
+        if(mantissa > 1.41421356f)
+        {
+            mantissa *= 0.5f;
+            exponent += 1.0f;
+        }
+        float t = (mantissa - 1.0f) / (mantissa + 1.0f);
+        float t2 = t * t;
+        return exponent + t * (LOG2_C1 + t2 * (LOG2_C3 + t2 * (LOG2_C5 + t2 * LOG2_C7)));
+    }
+
+    inline float Exp2(float y)
+    {
+        y = y > -126.0f ? y : -126.0f;
+        y = y < 127.0f ? y : 127.0f;
+        float n = nearbyintf(y);
+        float f = y - n;
+        float result = 1.0f + f * (EXP2_C1 + f * (EXP2_C2 + f * (EXP2_C3 + f * (EXP2_C4 + f * (EXP2_C5 + f * (EXP2_C6 + f * EXP2_C7))))));
+        uint32_t bits = static_cast<uint32_t>(static_cast<int>(n) + 127) << 23;
+        float scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        return result * scale;
+    }
+
+    inline float Pow(float x, float exponent)
+    {
+        return Exp2(exponent * Log2(x));
+    }
+
+#ifdef MATHLIB_SSE
+    inline __m128 Select(__m128 mask, __m128 whenTrue, __m128 whenFalse)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, whenTrue), _mm_andnot_ps(mask, whenFalse));
+    }
+
+    inline __m128 Log2(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128i exponentBits = _mm_sub_epi32(_mm_and_si128(_mm_srli_epi32(bits, 23), _mm_set1_epi32(0xff)), _mm_set1_epi32(127));
+        __m128 exponent = _mm_cvtepi32_ps(exponentBits);
+        __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+        __m128 above = _mm_cmpgt_ps(mantissa, _mm_set1_ps(1.41421356f));
+        mantissa = _mm_mul_ps(mantissa, Select(above, _mm_set1_ps(0.5f), _mm_set1_ps(1.0f)));
+        exponent = _mm_add_ps(exponent, _mm_and_ps(above, _mm_set1_ps(1.0f)));
+        __m128 t = _mm_div_ps(_mm_sub_ps(mantissa, _mm_set1_ps(1.0f)), _mm_add_ps(mantissa, _mm_set1_ps(1.0f)));
+        __m128 t2 = _mm_mul_ps(t, t);
+        __m128 result = _mm_add_ps(_mm_set1_ps(LOG2_C5), _mm_mul_ps(t2, _mm_set1_ps(LOG2_C7)));
+        result = _mm_add_ps(_mm_set1_ps(LOG2_C3), _mm_mul_ps(t2, result));
+        result = _mm_add_ps(_mm_set1_ps(LOG2_C1), _mm_mul_ps(t2, result));
+        return _mm_add_ps(exponent, _mm_mul_ps(t, result));
+    }
+
+    inline __m128 Exp2(__m128 y)
+    {
+        y = _mm_max_ps(y, _mm_set1_ps(-126.0f));
+        y = _mm_min_ps(y, _mm_set1_ps(127.0f));
+        __m128i integers = _mm_cvtps_epi32(y);
+        __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(integers));
+        __m128 result = _mm_add_ps(_mm_set1_ps(EXP2_C6), _mm_mul_ps(f, _mm_set1_ps(EXP2_C7)));
+        result = _mm_add_ps(_mm_set1_ps(EXP2_C5), _mm_mul_ps(f, result));
+        result = _mm_add_ps(_mm_set1_ps(EXP2_C4), _mm_mul_ps(f, result));
+        result = _mm_add_ps(_mm_set1_ps(EXP2_C3), _mm_mul_ps(f, result));
+        result = _mm_add_ps(_mm_set1_ps(EXP2_C2), _mm_mul_ps(f, result));
+        result = _mm_add_ps(_mm_set1_ps(EXP2_C1), _mm_mul_ps(f, result));
+        result = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(f, result));
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(integers, _mm_set1_epi32(127)), 23));
+        return _mm_mul_ps(result, scale);
+    }
+
+    inline __m128 Pow(__m128 x, float exponent)
+    {
+        return Exp2(_mm_mul_ps(_mm_set1_ps(exponent), Log2(x)));
+    }
+#endif
+
+    // Power segments of the sRGB curves without the scale which joins them to the linear segments
+    inline float DecodePower(float c)
+    {
+        return Pow(c * (1.0f / 1.055f) + 0.055f / 1.055f, 2.4f);
+    }
+
+    inline float EncodePower(float x)
+    {
+        return Pow(x, 1.0f / 2.4f);
+    }
+
+    /* Scales making the power segments meet the linear segments at the knees, computed as
+       linear(knee) / DecodePower(knee) and (linear(knee) + 0.055) / (1.055 * EncodePower(knee)) */
+    const float SRGB_DECODE_SCALE = 0.999999642f;
+    const float SRGB_ENCODE_SCALE = 1.00000012f;
+
+    /* Linear segment of the sRGB decode curve followed by the power segment. The power segment is
+       clamped to the value of the linear segment at the knee, so the curve is continuous and monotonic */
+    struct DecodeSrgb
+    {
+        float operator()(float c) const
+        {
+            const float knee = SRGB_DECODE_KNEE * (1.0f / 12.92f);
+            if(c <= SRGB_DECODE_KNEE)
+            {
+                return c * (1.0f / 12.92f);
+            }
+            float result = DecodePower(c) * SRGB_DECODE_SCALE;
+            return result > knee ? result : knee;
+        }
+
+#ifdef MATHLIB_SSE
+        __m128 operator()(__m128 c) const
+        {
+            const __m128 knee = _mm_set1_ps(SRGB_DECODE_KNEE * (1.0f / 12.92f));
+            __m128 base = _mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(1.0f / 1.055f)), _mm_set1_ps(0.055f / 1.055f));
+            __m128 result = _mm_max_ps(_mm_mul_ps(Pow(base, 2.4f), _mm_set1_ps(SRGB_DECODE_SCALE)), knee);
+            return Select(_mm_cmple_ps(c, _mm_set1_ps(SRGB_DECODE_KNEE)), _mm_mul_ps(c, _mm_set1_ps(1.0f / 12.92f)), result);
+        }
+#endif
+    };
+
+    // Linear segment of the sRGB encode curve followed by the power segment, joined like DecodeSrgb
+    struct EncodeSrgb
+    {
+        float operator()(float x) const
+        {
+            const float knee = SRGB_ENCODE_KNEE * 12.92f;
+            if(x <= SRGB_ENCODE_KNEE)
+            {
+                return x * 12.92f;
+            }
+            float result = EncodePower(x) * (1.055f * SRGB_ENCODE_SCALE) - 0.055f;
+            return result > knee ? result : knee;
+        }
+
+#ifdef MATHLIB_SSE
+        __m128 operator()(__m128 x) const
+        {
+            const __m128 knee = _mm_set1_ps(SRGB_ENCODE_KNEE * 12.92f);
+            __m128 result = _mm_sub_ps(_mm_mul_ps(Pow(x, 1.0f / 2.4f), _mm_set1_ps(1.055f * SRGB_ENCODE_SCALE)), _mm_set1_ps(0.055f));
+            result = _mm_max_ps(result, knee);
+            return Select(_mm_cmple_ps(x, _mm_set1_ps(SRGB_ENCODE_KNEE)), _mm_mul_ps(x, _mm_set1_ps(12.92f)), result);
+        }
+#endif
+    };
+
+    struct ClampUnit
+    {
+        float operator()(float x) const
+        {
+            return Saturate(x);
+        }
+
+#ifdef MATHLIB_SSE
+        __m128 operator()(__m128 x) const
+        {
+            return _mm_min_ps(_mm_max_ps(x, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        }
+#endif
+    };
+
+    struct MultiplyAddScalar
+    {
+        float multiplier;
+        float addend;
+
+        MultiplyAddScalar(float multiplier, float addend) : multiplier(multiplier), addend(addend)
+        {
+        }
+
+        float operator()(float x) const
+        {
+            return x * multiplier + addend;
+        }
+
+#ifdef MATHLIB_SSE
+        __m128 operator()(__m128 x) const
+        {
+            return _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(multiplier)), _mm_set1_ps(addend));
+        }
+#endif
+    };
+
+    template<class Function> void TransformPlane(float *values, size_t count, Function function)
+    {
+        size_t i = 0;
+#ifdef MATHLIB_SSE
+        for(; i + 4 <= count; i += 4)
+        {
+            _mm_storeu_ps(values + i, function(_mm_loadu_ps(values + i)));
+        }
+#endif
+        for(; i < count; i++)
+        {
+            values[i] = function(values[i]);
+        }
+    }
+
+    // Applies a function to r, g and b, alpha is kept
+    template<class Function> void TransformColorChannels(Color4f *colors, size_t count, Function function)
+    {
+#ifdef MATHLIB_SSE
+        const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+        for(size_t i = 0; i < count; i++)
+        {
+            __m128 value = _mm_loadu_ps(&colors[i].r);
+            __m128 result = Select(alphaMask, value, function(value));
+            _mm_storeu_ps(&colors[i].r, result);
+        }
+#else
+        for(size_t i = 0; i < count; i++)
+        {
+            colors[i].r = function(colors[i].r);
+            colors[i].g = function(colors[i].g);
+            colors[i].b = function(colors[i].b);
+        }
+#endif
+    }
+
+    // Runs function(first, last) over [0, count) on all hardware threads when count is large
+    template<class Function> void ParallelFor(size_t count, Function function)
+    {
+        size_t threadCount = thread::hardware_concurrency();
+        if(threadCount < 2 || count < MIN_PARALLEL_PIXELS)
+        {
+            function(size_t(0), count);
+            return;
+        }
+
+        size_t chunk = (count + threadCount - 1) / threadCount;
+        vector<thread> threads;
+        for(size_t first = chunk; first < count; first += chunk)
+        {
+            size_t last = first + chunk < count ? first + chunk : count;
+            threads.push_back(thread(function, first, last));
+        }
+        function(size_t(0), chunk);
+        for(size_t i = 0; i < threads.size(); i++)
+        {
+            threads[i].join();
+        }
+    }
+}
+
+float MathLib::SrgbToLinear(float value)
+{
+    return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float MathLib::LinearToSrgb(float value)
+{
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * powf(value, 1.0f / 2.4f) - 0.055f;
+}
+
+void MathLib::BlendColors(const Color4f *source, Color4f *destination, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+#ifdef MATHLIB_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 alphaMask = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+    for(size_t i = 0; i < count; i++)
+    {
+        __m128 s = _mm_loadu_ps(&source[i].r);
+        __m128 d = _mm_loadu_ps(&destination[i].r);
+        __m128 sa = _mm_shuffle_ps(s, s, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 factor = Select(alphaMask, one, sa);
+        __m128 result = _mm_add_ps(_mm_mul_ps(s, factor), _mm_mul_ps(d, _mm_sub_ps(one, sa)));
+        _mm_storeu_ps(&destination[i].r, result);
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        float sa = source[i].a;
+        float inv = 1.0f - sa;
+        destination[i].r = source[i].r * sa + destination[i].r * inv;
+        destination[i].g = source[i].g * sa + destination[i].g * inv;
+        destination[i].b = source[i].b * sa + destination[i].b * inv;
+        destination[i].a = sa + destination[i].a * inv;
+    }
+#endif
+}
+
+void MathLib::MultiplyAddColors(Color4f *colors, size_t count, const Color4f &multiplier, const Color4f &addend)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+#ifdef MATHLIB_SSE
+    const __m128 m = _mm_loadu_ps(&multiplier.r);
+    const __m128 a = _mm_loadu_ps(&addend.r);
+    for(size_t i = 0; i < count; i++)
+    {
+        _mm_storeu_ps(&colors[i].r, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&colors[i].r), m), a));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        colors[i].r = colors[i].r * multiplier.r + addend.r;
+        colors[i].g = colors[i].g * multiplier.g + addend.g;
+        colors[i].b = colors[i].b * multiplier.b + addend.b;
+        colors[i].a = colors[i].a * multiplier.a + addend.a;
+    }
+#endif
+}
+
+void MathLib::ClampColors(Color4f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&colors[0].r, count * 4, ClampUnit());
+}
+
+void MathLib::SrgbToLinear(Color4f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    TransformColorChannels(colors, count, DecodeSrgb());
+}
+
+void MathLib::LinearToSrgb(Color4f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    TransformColorChannels(colors, count, EncodeSrgb());
+}
+
+void MathLib::PackRGBA8(const Color4f *colors, uint32_t *packed, size_t count, bool srgb)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PACK_BATCH, count);
+    if(srgb)
+    {
+        const SrgbTables &tables = GetSrgbTables();
+        for(size_t i = 0; i < count; i++)
+        {
+            packed[i] = ToSrgbByte(tables, colors[i].r) | (ToSrgbByte(tables, colors[i].g) << 8) |
+                (ToSrgbByte(tables, colors[i].b) << 16) | (ToByte(colors[i].a) << 24);
+        }
+        return;
+    }
+
+#ifdef MATHLIB_SSE
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    for(size_t i = 0; i < count; i++)
+    {
+        __m128 value = ClampUnit()(_mm_loadu_ps(&colors[i].r));
+        __m128i integers = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, scale), half));
+        integers = _mm_packs_epi32(integers, integers);
+        integers = _mm_packus_epi16(integers, integers);
+        packed[i] = static_cast<uint32_t>(_mm_cvtsi128_si32(integers));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        packed[i] = ToByte(colors[i].r) | (ToByte(colors[i].g) << 8) | (ToByte(colors[i].b) << 16) | (ToByte(colors[i].a) << 24);
+    }
+#endif
+}
+
+void MathLib::UnpackRGBA8(const uint32_t *packed, Color4f *colors, size_t count, bool srgb)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PACK_BATCH, count);
+    const float scale = 1.0f / 255.0f;
+    if(srgb)
+    {
+        const SrgbTables &tables = GetSrgbTables();
+        for(size_t i = 0; i < count; i++)
+        {
+            uint32_t value = packed[i];
+            colors[i] = Color4f(tables.decode[value & 0xff], tables.decode[(value >> 8) & 0xff],
+                    tables.decode[(value >> 16) & 0xff], (value >> 24) * scale);
+        }
+        return;
+    }
+
+#ifdef MATHLIB_SSE
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 scales = _mm_set1_ps(scale);
+    for(size_t i = 0; i < count; i++)
+    {
+        __m128i integers = _mm_cvtsi32_si128(static_cast<int>(packed[i]));
+        integers = _mm_unpacklo_epi16(_mm_unpacklo_epi8(integers, zero), zero);
+        _mm_storeu_ps(&colors[i].r, _mm_mul_ps(_mm_cvtepi32_ps(integers), scales));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        uint32_t value = packed[i];
+        colors[i] = Color4f((value & 0xff) * scale, ((value >> 8) & 0xff) * scale, ((value >> 16) & 0xff) * scale, (value >> 24) * scale);
+    }
+#endif
+}
+
+void MathLib::MultiplyAddColors(Color3f *colors, size_t count, const Color3f &multiplier, const Color3f &addend)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    float *values = &colors[0].r;
+    const size_t valueCount = count * 3;
+    const float m[3] = { multiplier.r, multiplier.g, multiplier.b };
+    const float a[3] = { addend.r, addend.g, addend.b };
+    size_t i = 0;
+#ifdef MATHLIB_SSE
+    // three vectors hold four colors, so the channel order of the constants rotates from one vector to the next
+    const __m128 multipliers[3] = { _mm_setr_ps(m[0], m[1], m[2], m[0]), _mm_setr_ps(m[1], m[2], m[0], m[1]), _mm_setr_ps(m[2], m[0], m[1], m[2]) };
+    const __m128 addends[3] = { _mm_setr_ps(a[0], a[1], a[2], a[0]), _mm_setr_ps(a[1], a[2], a[0], a[1]), _mm_setr_ps(a[2], a[0], a[1], a[2]) };
+    for(; i + 12 <= valueCount; i += 12)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            float *v = values + i + 4 * j;
+            _mm_storeu_ps(v, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(v), multipliers[j]), addends[j]));
+        }
+    }
+#endif
+    for(; i < valueCount; i++)
+    {
+        values[i] = values[i] * m[i % 3] + a[i % 3];
+    }
+}
+
+void MathLib::ClampColors(Color3f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&colors[0].r, count * 3, ClampUnit());
+}
+
+void MathLib::SrgbToLinear(Color3f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&colors[0].r, count * 3, DecodeSrgb());
+}
+
+void MathLib::LinearToSrgb(Color3f *colors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&colors[0].r, count * 3, EncodeSrgb());
+}
+
+void MathLib::PackRGBA8(const Color3f *colors, uint32_t *packed, size_t count, bool srgb)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PACK_BATCH, count);
+    if(srgb)
+    {
+        const SrgbTables &tables = GetSrgbTables();
+        for(size_t i = 0; i < count; i++)
+        {
+            packed[i] = ToSrgbByte(tables, colors[i].r) | (ToSrgbByte(tables, colors[i].g) << 8) |
+                (ToSrgbByte(tables, colors[i].b) << 16) | 0xff000000u;
+        }
+        return;
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        packed[i] = ToByte(colors[i].r) | (ToByte(colors[i].g) << 8) | (ToByte(colors[i].b) << 16) | 0xff000000u;
+    }
+}
+
+void MathLib::UnpackRGBA8(const uint32_t *packed, Color3f *colors, size_t count, bool srgb)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PACK_BATCH, count);
+    const float scale = 1.0f / 255.0f;
+    const SrgbTables *tables = srgb ? &GetSrgbTables() : 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        uint32_t value = packed[i];
+        if(tables)
+        {
+            colors[i] = Color3f(tables->decode[value & 0xff], tables->decode[(value >> 8) & 0xff], tables->decode[(value >> 16) & 0xff]);
+        }
+        else
+        {
+            colors[i] = Color3f((value & 0xff) * scale, ((value >> 8) & 0xff) * scale, ((value >> 16) & 0xff) * scale);
+        }
+    }
+}
+
+ColorPlanes::ColorPlanes()
+{
+}
+
+ColorPlanes::ColorPlanes(size_t count)
+{
+    Resize(count);
+}
+
+void ColorPlanes::Resize(size_t count)
+{
+    r.resize(count, 0.0f);
+    g.resize(count, 0.0f);
+    b.resize(count, 0.0f);
+    a.resize(count, 0.0f);
+}
+
+size_t ColorPlanes::GetSize() const
+{
+    return r.size();
+}
+
+void ColorPlanes::Load(const Color4f *colors, size_t count)
+{
+    Resize(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        r[i] = colors[i].r;
+        g[i] = colors[i].g;
+        b[i] = colors[i].b;
+        a[i] = colors[i].a;
+    }
+}
+
+void ColorPlanes::Store(Color4f *colors) const
+{
+    for(size_t i = 0; i < r.size(); i++)
+    {
+        colors[i] = Color4f(r[i], g[i], b[i], a[i]);
+    }
+}
+
+void ColorPlanes::Blend(const ColorPlanes &source)
+{
+    if(source.GetSize() != GetSize())
+    {
+        throw std::range_error("Color buffers must have the same size.");
+    }
+
+    size_t count = GetSize();
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    size_t i = 0;
+#ifdef MATHLIB_SSE
+    const __m128 one = _mm_set1_ps(1.0f);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 sa = _mm_loadu_ps(&source.a[i]);
+        __m128 inv = _mm_sub_ps(one, sa);
+        _mm_storeu_ps(&r[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&source.r[i]), sa), _mm_mul_ps(_mm_loadu_ps(&r[i]), inv)));
+        _mm_storeu_ps(&g[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&source.g[i]), sa), _mm_mul_ps(_mm_loadu_ps(&g[i]), inv)));
+        _mm_storeu_ps(&b[i], _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&source.b[i]), sa), _mm_mul_ps(_mm_loadu_ps(&b[i]), inv)));
+        _mm_storeu_ps(&a[i], _mm_add_ps(sa, _mm_mul_ps(_mm_loadu_ps(&a[i]), inv)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        float sa = source.a[i];
+        float inv = 1.0f - sa;
+        r[i] = source.r[i] * sa + r[i] * inv;
+        g[i] = source.g[i] * sa + g[i] * inv;
+        b[i] = source.b[i] * sa + b[i] * inv;
+        a[i] = sa + a[i] * inv;
+    }
+}
+
+void ColorPlanes::MultiplyAdd(const Color4f &multiplier, const Color4f &addend)
+{
+    size_t count = GetSize();
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&r[0], count, MultiplyAddScalar(multiplier.r, addend.r));
+    TransformPlane(&g[0], count, MultiplyAddScalar(multiplier.g, addend.g));
+    TransformPlane(&b[0], count, MultiplyAddScalar(multiplier.b, addend.b));
+    TransformPlane(&a[0], count, MultiplyAddScalar(multiplier.a, addend.a));
+}
+
+void ColorPlanes::Clamp()
+{
+    size_t count = GetSize();
+    MATHLIB_PROFILE_BATCH(PROFILE_COLOR_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&r[0], count, ClampUnit());
+    TransformPlane(&g[0], count, ClampUnit());
+    TransformPlane(&b[0], count, ClampUnit());
+    TransformPlane(&a[0], count, ClampUnit());
+}
+
+void ColorPlanes::SrgbToLinear()
+{
+    size_t count = GetSize();
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&r[0], count, DecodeSrgb());
+    TransformPlane(&g[0], count, DecodeSrgb());
+    TransformPlane(&b[0], count, DecodeSrgb());
+}
+
+void ColorPlanes::LinearToSrgb()
+{
+    size_t count = GetSize();
+    MATHLIB_PROFILE_BATCH(PROFILE_SRGB_BATCH, count);
+    if(count == 0)
+    {
+        return;
+    }
+    TransformPlane(&r[0], count, EncodeSrgb());
+    TransformPlane(&g[0], count, EncodeSrgb());
+    TransformPlane(&b[0], count, EncodeSrgb());
+}
+
+ColorBuffer::ColorBuffer() : width(0), height(0)
+{
+}
+
+ColorBuffer::ColorBuffer(size_t width, size_t height) : width(0), height(0)
+{
+    Resize(width, height);
+}
+
+void ColorBuffer::Resize(size_t width, size_t height)
+{
+    this->width = width;
+    this->height = height;
+    pixels.assign(width * height, Color4f(0.0f, 0.0f, 0.0f, 0.0f));
+}
+
+size_t ColorBuffer::GetWidth() const
+{
+    return width;
+}
+
+size_t ColorBuffer::GetHeight() const
+{
+    return height;
+}
+
+const Color4f& ColorBuffer::GetPixel(size_t x, size_t y) const
+{
+    return pixels[y * width + x];
+}
+
+void ColorBuffer::SetPixel(size_t x, size_t y, const Color4f &color)
+{
+    pixels[y * width + x] = color;
+}
+
+Color4f* ColorBuffer::GetPointer()
+{
+    return pixels.empty() ? 0 : &pixels[0];
+}
+
+const Color4f* ColorBuffer::GetPointer() const
+{
+    return pixels.empty() ? 0 : &pixels[0];
+}
+
+void ColorBuffer::Blend(const ColorBuffer &source)
+{
+    if(source.width != width || source.height != height)
+    {
+        throw std::range_error("Color buffers must have the same size.");
+    }
+    const Color4f *in = source.GetPointer();
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { BlendColors(in + first, out + first, last - first); });
+}
+
+void ColorBuffer::MultiplyAdd(const Color4f &multiplier, const Color4f &addend)
+{
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=, &multiplier, &addend](size_t first, size_t last) { MultiplyAddColors(out + first, last - first, multiplier, addend); });
+}
+
+void ColorBuffer::Clamp()
+{
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { ClampColors(out + first, last - first); });
+}
+
+void ColorBuffer::SrgbToLinear()
+{
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { MathLib::SrgbToLinear(out + first, last - first); });
+}
+
+void ColorBuffer::LinearToSrgb()
+{
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { MathLib::LinearToSrgb(out + first, last - first); });
+}
+
+void ColorBuffer::ToRGBA8(uint32_t *packed, bool srgb) const
+{
+    const Color4f *in = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { PackRGBA8(in + first, packed + first, last - first, srgb); });
+}
+
+void ColorBuffer::FromRGBA8(const uint32_t *packed, bool srgb)
+{
+    Color4f *out = GetPointer();
+    ParallelFor(pixels.size(), [=](size_t first, size_t last) { UnpackRGBA8(packed + first, out + first, last - first, srgb); });
+}
+
+void ColorBuffer::FromPoints(const Point3f *points)
+{
+    for(size_t i = 0; i < pixels.size(); i++)
+    {
+        Color3f color(points[i]);
+        pixels[i] = Color4f(color.r, color.g, color.b, 1.0f);
+    }
+}
@@ -0,0 +1,185 @@
+#ifndef MATH_COLOR_H
+#define MATH_COLOR_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+#include "vec.h"
+
+/*! \file color.h
+  \brief Contains color buffer types and batched color operations.
+  Packed RGBA8 values keep red in the lowest byte. Alpha is always linear,
+  sRGB conversions only touch the r, g and b channels.
+  Color3f arrays have the same operations as Color4f arrays except blending, which needs alpha.
+  */
+
+namespace MathLib
+{
+    /*! Converts a single sRGB encoded value to linear using the exact curve */
+    float SrgbToLinear(float value);
+
+    /*! Converts a single linear value to sRGB using the exact curve */
+    float LinearToSrgb(float value);
+
+    /*! Blends source over destination: rgb = src * src.a + dst * (1 - src.a), a = src.a + dst.a * (1 - src.a) */
+    void BlendColors(const Color4f *source, Color4f *destination, size_t count);
+
+    /*! Computes color * multiplier + addend for every color */
+    void MultiplyAddColors(Color4f *colors, size_t count, const Color4f &multiplier, const Color4f &addend);
+
+    /*! Clamps every channel to [0, 1] */
+    void ClampColors(Color4f *colors, size_t count);
+
+    /*! Decodes sRGB to linear with an approximation of the power segment, input is expected in [0, 1].
+      The relative error is below 2e-6 where the exact result is a normal float, denormal results are
+      within one denormal step of it. The power segment is joined to the linear segment
+      at the knee, so the curve has no jump and does not decrease there
+      */
+    void SrgbToLinear(Color4f *colors, size_t count);
+
+    /*! Encodes linear to sRGB with an approximation of the power segment, input is expected in [0, 1].
+      Accuracy and the knee are handled as in SrgbToLinear(Color4f*, size_t)
+      */
+    void LinearToSrgb(Color4f *colors, size_t count);
+
+    /*! Converts colors to packed RGBA8, values are clamped and NaN gives 0
+      \param srgb Encode r, g and b to sRGB. The bytes equal LinearToSrgb(float) scaled to [0, 255] and rounded,
+      found with a coarse table corrected by the 256 byte thresholds
+      */
+    void PackRGBA8(const Color4f *colors, uint32_t *packed, size_t count, bool srgb = false);
+
+    /*! Converts packed RGBA8 values to colors
+      \param srgb Decode r, g and b from sRGB through a lookup table
+      */
+    void UnpackRGBA8(const uint32_t *packed, Color4f *colors, size_t count, bool srgb = false);
+
+    /*! Computes color * multiplier + addend for every color */
+    void MultiplyAddColors(Color3f *colors, size_t count, const Color3f &multiplier, const Color3f &addend);
+
+    /*! Clamps every channel to [0, 1] */
+    void ClampColors(Color3f *colors, size_t count);
+
+    /*! Decodes sRGB to linear, see SrgbToLinear(Color4f*, size_t) */
+    void SrgbToLinear(Color3f *colors, size_t count);
+
+    /*! Encodes linear to sRGB, see LinearToSrgb(Color4f*, size_t) */
+    void LinearToSrgb(Color3f *colors, size_t count);
+
+    /*! Converts colors to packed RGBA8 with alpha 255, see PackRGBA8(const Color4f*, uint32_t*, size_t, bool) */
+    void PackRGBA8(const Color3f *colors, uint32_t *packed, size_t count, bool srgb = false);
+
+    /*! Converts packed RGBA8 values to colors dropping alpha, see UnpackRGBA8(const uint32_t*, Color4f*, size_t, bool) */
+    void UnpackRGBA8(const uint32_t *packed, Color3f *colors, size_t count, bool srgb = false);
+
+    //! Color buffer stored as separate channel planes (SoA)
+    /*!
+      Operations process four pixels of one channel at a time.
+      */
+    class ColorPlanes
+    {
+        public:
+            /*! Creates an empty buffer */
+            ColorPlanes();
+
+            /*! Creates a buffer of count black, transparent pixels */
+            explicit ColorPlanes(size_t count);
+
+            /*! Changes the number of pixels */
+            void Resize(size_t count);
+
+            /*! Returns number of pixels */
+            size_t GetSize() const;
+
+            /*! Fills the planes from an array of colors, resizing the buffer */
+            void Load(const Color4f *colors, size_t count);
+
+            /*! Writes the planes to an array of GetSize() colors */
+            void Store(Color4f *colors) const;
+
+            /*! Blends source over this buffer, see BlendColors */
+            void Blend(const ColorPlanes &source);
+
+            /*! Computes color * multiplier + addend for every pixel */
+            void MultiplyAdd(const Color4f &multiplier, const Color4f &addend);
+
+            /*! Clamps every channel to [0, 1] */
+            void Clamp();
+
+            /*! Decodes sRGB to linear, see SrgbToLinear(Color4f*, size_t) */
+            void SrgbToLinear();
+
+            /*! Encodes linear to sRGB, see LinearToSrgb(Color4f*, size_t) */
+            void LinearToSrgb();
+
+            std::vector<float> r;	//!< red plane
+            std::vector<float> g;	//!< green plane
+            std::vector<float> b;	//!< blue plane
+            std::vector<float> a;	//!< alpha plane
+    };
+
+    //! Image of Color4f pixels stored row by row (AoS)
+    /*!
+      Whole-image operations are split across hardware threads for large images.
+      */
+    class ColorBuffer
+    {
+        public:
+            /*! Creates an empty image */
+            ColorBuffer();
+
+            /*! Creates an image filled with black, transparent pixels */
+            ColorBuffer(size_t width, size_t height);
+
+            /*! Changes the image size, pixel content is not preserved */
+            void Resize(size_t width, size_t height);
+
+            /*! Returns width in pixels */
+            size_t GetWidth() const;
+
+            /*! Returns height in pixels */
+            size_t GetHeight() const;
+
+            /*! Returns a pixel */
+            const Color4f& GetPixel(size_t x, size_t y) const;
+
+            /*! Sets a pixel */
+            void SetPixel(size_t x, size_t y, const Color4f &color);
+
+            /*! Returns pointer on the first pixel */
+            Color4f* GetPointer();
+
+            /*! Returns pointer on the first pixel */
+            const Color4f* GetPointer() const;
+
+            /*! Blends an image of the same size over this one, see BlendColors */
+            void Blend(const ColorBuffer &source);
+
+            /*! Computes color * multiplier + addend for every pixel */
+            void MultiplyAdd(const Color4f &multiplier, const Color4f &addend);
+
+            /*! Clamps every channel to [0, 1] */
+            void Clamp();
+
+            /*! Decodes sRGB to linear, see SrgbToLinear(Color4f*, size_t) */
+            void SrgbToLinear();
+
+            /*! Encodes linear to sRGB, see LinearToSrgb(Color4f*, size_t) */
+            void LinearToSrgb();
+
+            /*! Converts the image to packed RGBA8, see PackRGBA8 */
+            void ToRGBA8(uint32_t *packed, bool srgb = false) const;
+
+            /*! Fills the image from packed RGBA8 values, see UnpackRGBA8 */
+            void FromRGBA8(const uint32_t *packed, bool srgb = false);
+
+            /*! Fills the image from points the same way Color3f(const Point3f&) does, alpha is set to 1 */
+            void FromPoints(const Point3f *points);
+
+        private:
+            size_t width;
+            size_t height;
+            std::vector<Color4f> pixels;
+    };
+}
+
+#endif
@@ -0,0 +1,654 @@
+#include <cmath>
+#include "decompose.h"
+#include "simd.h"
+#include "profiler.h"
+
+using namespace MathLib;
+
+namespace
+{
+    const int MAX_POLAR_ITERATIONS = 32;
+    const int MAX_JACOBI_SWEEPS = 32;
+    const float POLAR_SCALING_LIMIT = 0.01f;
+    const float POLAR_SCALING_CONDITION = 1e-3f;
+    // largest entries outside of this range are scaled to [0.5, 1) before iterating
+    const float NORMALIZE_BELOW = 1.0f / 4294967296.0f;
+    const float NORMALIZE_ABOVE = 4294967296.0f;
+
+    float Determinant3x3(const float a[3][3])
+    {
+        return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+            - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+            + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    }
+
+    void Load3x3(const Mat4 &matrix, float a[3][3])
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                a[i][j] = matrix.m[i][j];
+            }
+        }
+    }
+
+    void Store3x3(Mat4 &matrix, const float a[3][3])
+    {
+        matrix.SetIdentity();
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                matrix.m[i][j] = a[i][j];
+            }
+        }
+    }
+
+    //! Scales a 3x3 array so that its largest entry is in [0.5, 1), returns the exponent removed
+    int ScaleToUnit(float a[3][3], float largest)
+    {
+        int exponent;
+        frexpf(largest, &exponent);
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                a[i][j] = ldexpf(a[i][j], -exponent);
+            }
+        }
+        return exponent;
+    }
+
+    /*! Scales a 3x3 array by a power of two when its largest entry is far from 1, so that the
+      squares and cofactors used by the iterative solvers neither overflow nor underflow.
+      Scaling by a power of two is exact.
+      \return Exponent to apply to scale dependent results, 0 if the array was left unchanged
+      */
+    inline int Normalize3x3(float a[3][3])
+    {
+        float largest = 0.0f;
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                float value = fabsf(a[i][j]);
+                largest = value > largest ? value : largest;
+            }
+        }
+        if(largest < NORMALIZE_ABOVE && largest > NORMALIZE_BELOW)
+        {
+            return 0;
+        }
+        return largest > 0.0f && std::isfinite(largest) ? ScaleToUnit(a, largest) : 0;
+    }
+
+    float SquaredNorm3x3(const float a[3][3])
+    {
+        float sum = 0.0f;
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                sum += a[i][j] * a[i][j];
+            }
+        }
+        return sum;
+    }
+
+    void NormalizeRow(float *row)
+    {
+        float length = sqrtf(row[0] * row[0] + row[1] * row[1] + row[2] * row[2]);
+        if(length > 0.0f)
+        {
+            float inv = 1.0f / length;
+            row[0] *= inv;
+            row[1] *= inv;
+            row[2] *= inv;
+        }
+    }
+
+#ifdef MATHLIB_SSE
+    //! Returns a mask of the lanes after column k
+    inline __m128 ColumnsAfter(int k)
+    {
+        return _mm_castsi128_ps(_mm_cmpgt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(k)));
+    }
+
+    //! Returns a mask of lane k
+    inline __m128 Column(int k)
+    {
+        return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(k)));
+    }
+
+    //! Subtracts factor * pivotRow from the lanes of row selected by mask, the other lanes keep their bits
+    inline __m128 EliminateRow(__m128 row, __m128 pivotRow, float factor, __m128 mask)
+    {
+        __m128 product = _mm_and_ps(_mm_mul_ps(_mm_set1_ps(factor), pivotRow), mask);
+        return _mm_sub_ps(row, product);
+    }
+#endif
+
+    // Rows of 4 floats are only written as whole vectors on the SSE path, a 16 byte load
+    // of a row right after a scalar store to it would miss store forwarding
+    inline void SwapRows(float *a, float *b)
+    {
+#ifdef MATHLIB_SSE
+        __m128 row = _mm_loadu_ps(a);
+        _mm_storeu_ps(a, _mm_loadu_ps(b));
+        _mm_storeu_ps(b, row);
+#else
+        for(int j = 0; j < 4; j++)
+        {
+            float temp = a[j];
+            a[j] = b[j];
+            b[j] = temp;
+        }
+#endif
+    }
+}
+
+bool MathLib::DecomposeLU(Mat4 &matrix, int pivot[4])
+{
+    float (*a)[4] = matrix.m;
+    for(int k = 0; k < 4; k++)
+    {
+        int p = k;
+        for(int i = k + 1; i < 4; i++)
+        {
+            if(fabsf(a[i][k]) > fabsf(a[p][k]))
+            {
+                p = i;
+            }
+        }
+        pivot[k] = p;
+        if(a[p][k] == 0.0f)
+        {
+            return false;
+        }
+        if(p != k)
+        {
+            SwapRows(a[k], a[p]);
+        }
+        float inv = 1.0f / a[k][k];
+#ifdef MATHLIB_SSE
+        __m128 pivotRow = _mm_loadu_ps(a[k]);
+        __m128 after = ColumnsAfter(k);
+        __m128 column = Column(k);
+        for(int i = k + 1; i < 4; i++)
+        {
+            float factor = a[i][k] * inv;
+            __m128 row = EliminateRow(_mm_loadu_ps(a[i]), pivotRow, factor, after);
+            _mm_storeu_ps(a[i], _mm_or_ps(_mm_and_ps(column, _mm_set1_ps(factor)), _mm_andnot_ps(column, row)));
+        }
+#else
+        for(int i = k + 1; i < 4; i++)
+        {
+            a[i][k] *= inv;
+            for(int j = k + 1; j < 4; j++)
+            {
+                a[i][j] -= a[i][k] * a[k][j];
+            }
+        }
+#endif
+    }
+    return true;
+}
+
+size_t MathLib::DecomposeLU(Mat4 *matrices, int (*pivots)[4], size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    size_t singular = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!DecomposeLU(matrices[i], pivots[i]))
+        {
+            singular++;
+        }
+    }
+    return singular;
+}
+
+void MathLib::SolveLU(const Mat4 &lu, const int pivot[4], Point4f &b)
+{
+    float x[4] = { b.x, b.y, b.z, b.w };
+    for(int k = 0; k < 4; k++)
+    {
+        float temp = x[k];
+        x[k] = x[pivot[k]];
+        x[pivot[k]] = temp;
+    }
+    for(int i = 1; i < 4; i++)
+    {
+        for(int j = 0; j < i; j++)
+        {
+            x[i] -= lu.m[i][j] * x[j];
+        }
+    }
+    for(int i = 3; i >= 0; i--)
+    {
+        for(int j = i + 1; j < 4; j++)
+        {
+            x[i] -= lu.m[i][j] * x[j];
+        }
+        x[i] /= lu.m[i][i];
+    }
+    b = Point4f(x[0], x[1], x[2], x[3]);
+}
+
+bool MathLib::Solve(const Mat4 &matrix, const Point4f &b, Point4f &x)
+{
+    Mat4 lu(matrix);
+    int pivot[4];
+    if(!DecomposeLU(lu, pivot))
+    {
+        return false;
+    }
+    x = b;
+    SolveLU(lu, pivot, x);
+    return true;
+}
+
+bool MathLib::Solve3x3(const Mat4 &matrix, const Vec3f &b, Vec3f &x)
+{
+    // augmented rows, column 3 holds b
+    float a[3][4] =
+    {
+        { matrix.m[0][0], matrix.m[0][1], matrix.m[0][2], b.x },
+        { matrix.m[1][0], matrix.m[1][1], matrix.m[1][2], b.y },
+        { matrix.m[2][0], matrix.m[2][1], matrix.m[2][2], b.z }
+    };
+
+    for(int k = 0; k < 3; k++)
+    {
+        int p = k;
+        for(int i = k + 1; i < 3; i++)
+        {
+            if(fabsf(a[i][k]) > fabsf(a[p][k]))
+            {
+                p = i;
+            }
+        }
+        if(a[p][k] == 0.0f)
+        {
+            return false;
+        }
+        if(p != k)
+        {
+            SwapRows(a[k], a[p]);
+        }
+#ifdef MATHLIB_SSE
+        __m128 pivotRow = _mm_loadu_ps(a[k]);
+        __m128 after = ColumnsAfter(k);
+#endif
+        for(int i = k + 1; i < 3; i++)
+        {
+            float factor = a[i][k] / a[k][k];
+#ifdef MATHLIB_SSE
+            _mm_storeu_ps(a[i], EliminateRow(_mm_loadu_ps(a[i]), pivotRow, factor, after));
+#else
+            for(int j = k + 1; j < 4; j++)
+            {
+                a[i][j] -= factor * a[k][j];
+            }
+#endif
+        }
+    }
+    float v[3];
+    v[2] = a[2][3] / a[2][2];
+    v[1] = (a[1][3] - a[1][2] * v[2]) / a[1][1];
+    v[0] = (a[0][3] - a[0][1] * v[1] - a[0][2] * v[2]) / a[0][0];
+    x = Vec3f(v[0], v[1], v[2]);
+    return true;
+}
+
+size_t MathLib::Solve3x3(const Mat4 *matrices, Vec3f *vectors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    size_t singular = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!Solve3x3(matrices[i], vectors[i], vectors[i]))
+        {
+            singular++;
+        }
+    }
+    return singular;
+}
+
+void MathLib::Orthonormalize(Mat4 &matrix)
+{
+    float *r0 = matrix.m[0];
+    float *r1 = matrix.m[1];
+    float *r2 = matrix.m[2];
+
+    NormalizeRow(r0);
+    float d = r0[0] * r1[0] + r0[1] * r1[1] + r0[2] * r1[2];
+    r1[0] -= d * r0[0];
+    r1[1] -= d * r0[1];
+    r1[2] -= d * r0[2];
+    NormalizeRow(r1);
+    r2[0] = r0[1] * r1[2] - r0[2] * r1[1];
+    r2[1] = r0[2] * r1[0] - r0[0] * r1[2];
+    r2[2] = r0[0] * r1[1] - r0[1] * r1[0];
+}
+
+void MathLib::Orthonormalize(Mat4 *matrices, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        Orthonormalize(matrices[i]);
+    }
+}
+
+bool MathLib::DecomposeQR(const Mat4 &matrix, Mat4 &q, Mat4 &r)
+{
+    float a[3][3];
+    Load3x3(matrix, a);
+    int exponent = Normalize3x3(a);
+    float qa[3][3] = { { 0.0f } };
+    float ra[3][3] = { { 0.0f } };
+
+    for(int j = 0; j < 3; j++)
+    {
+        float v[3] = { a[0][j], a[1][j], a[2][j] };
+        for(int k = 0; k < j; k++)
+        {
+            float d = qa[0][k] * v[0] + qa[1][k] * v[1] + qa[2][k] * v[2];
+            ra[k][j] = d;
+            v[0] -= d * qa[0][k];
+            v[1] -= d * qa[1][k];
+            v[2] -= d * qa[2][k];
+        }
+        float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if(length == 0.0f)
+        {
+            return false;
+        }
+        ra[j][j] = length;
+        for(int i = 0; i < 3; i++)
+        {
+            qa[i][j] = v[i] / length;
+        }
+    }
+
+    if(exponent != 0)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = i; j < 3; j++)
+            {
+                ra[i][j] = ldexpf(ra[i][j], exponent);
+            }
+        }
+    }
+
+    Store3x3(q, qa);
+    Store3x3(r, ra);
+    return true;
+}
+
+size_t MathLib::DecomposeQR(const Mat4 *matrices, Mat4 *q, Mat4 *r, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    size_t dependent = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!DecomposeQR(matrices[i], q[i], r[i]))
+        {
+            dependent++;
+        }
+    }
+    return dependent;
+}
+
+bool MathLib::DecomposePolar(const Mat4 &matrix, Mat4 &rotation, Mat4 &stretch)
+{
+    float a[3][3];
+    float u[3][3];
+    Load3x3(matrix, a);
+    Load3x3(matrix, u);
+    // the orthogonal factor does not depend on the scale of the matrix
+    Normalize3x3(u);
+    // well conditioned matrices converge quickly without scaling, |det| / |u|^3 is small for the others
+    float squaredNorm = SquaredNorm3x3(u);
+    float initialDeterminant = Determinant3x3(u);
+    bool scaled = initialDeterminant * initialDeterminant < POLAR_SCALING_CONDITION * squaredNorm * squaredNorm * squaredNorm;
+
+    for(int iteration = 0; iteration < MAX_POLAR_ITERATIONS; iteration++)
+    {
+        float determinant = Determinant3x3(u);
+        if(determinant == 0.0f || !std::isfinite(determinant))
+        {
+            return false;
+        }
+
+        // u^-T is the cofactor matrix divided by the determinant
+        float inv = 1.0f / determinant;
+        float c[3][3];
+        c[0][0] = (u[1][1] * u[2][2] - u[1][2] * u[2][1]) * inv;
+        c[0][1] = (u[1][2] * u[2][0] - u[1][0] * u[2][2]) * inv;
+        c[0][2] = (u[1][0] * u[2][1] - u[1][1] * u[2][0]) * inv;
+        c[1][0] = (u[0][2] * u[2][1] - u[0][1] * u[2][2]) * inv;
+        c[1][1] = (u[0][0] * u[2][2] - u[0][2] * u[2][0]) * inv;
+        c[1][2] = (u[0][1] * u[2][0] - u[0][0] * u[2][1]) * inv;
+        c[2][0] = (u[0][1] * u[1][2] - u[0][2] * u[1][1]) * inv;
+        c[2][1] = (u[0][2] * u[1][0] - u[0][0] * u[1][2]) * inv;
+        c[2][2] = (u[0][0] * u[1][1] - u[0][1] * u[1][0]) * inv;
+
+        // Frobenius norm scaling keeps the iteration count low for nearly singular matrices,
+        // it is turned off close to convergence where the plain iteration converges quadratically
+        if(scaled)
+        {
+            float gamma = sqrtf(sqrtf(SquaredNorm3x3(c) / SquaredNorm3x3(u)));
+            if(!std::isfinite(gamma) || gamma == 0.0f)
+            {
+                return false;
+            }
+            float inverseGamma = 1.0f / gamma;
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    u[i][j] *= gamma;
+                    c[i][j] *= inverseGamma;
+                }
+            }
+        }
+
+        float change = 0.0f;
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                float next = 0.5f * (u[i][j] + c[i][j]);
+                change += fabsf(next - u[i][j]);
+                u[i][j] = next;
+            }
+        }
+        if(change < 1e-6f)
+        {
+            break;
+        }
+        scaled = scaled && change > POLAR_SCALING_LIMIT;
+    }
+
+    float s[3][3];
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            s[i][j] = u[0][i] * a[0][j] + u[1][i] * a[1][j] + u[2][i] * a[2][j];
+        }
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = i + 1; j < 3; j++)
+        {
+            float average = 0.5f * (s[i][j] + s[j][i]);
+            s[i][j] = average;
+            s[j][i] = average;
+        }
+    }
+
+    Store3x3(rotation, u);
+    Store3x3(stretch, s);
+    return true;
+}
+
+size_t MathLib::DecomposePolar(const Mat4 *matrices, Mat4 *rotations, Mat4 *stretches, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    size_t singular = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!DecomposePolar(matrices[i], rotations[i], stretches[i]))
+        {
+            singular++;
+        }
+    }
+    return singular;
+}
+
+void MathLib::EigenSymmetric3x3(const Mat4 &matrix, Vec3f &eigenvalues, Mat4 &eigenvectors)
+{
+    float a[3][3];
+    Load3x3(matrix, a);
+    int exponent = Normalize3x3(a);
+    float v[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+
+    for(int sweep = 0; sweep < MAX_JACOBI_SWEEPS; sweep++)
+    {
+        float off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        float diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+        if(off <= 1e-14f * diagonal || off == 0.0f)
+        {
+            break;
+        }
+
+        for(int p = 0; p < 2; p++)
+        {
+            for(int q = p + 1; q < 3; q++)
+            {
+                if(a[p][q] == 0.0f)
+                {
+                    continue;
+                }
+                float theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]);
+                float t = 1.0f / (fabsf(theta) + sqrtf(theta * theta + 1.0f));
+                if(theta < 0.0f)
+                {
+                    t = -t;
+                }
+                float c = 1.0f / sqrtf(t * t + 1.0f);
+                float s = t * c;
+
+                // a = J^T a J, v = v J with J the rotation in the (p, q) plane
+                for(int k = 0; k < 3; k++)
+                {
+                    float akp = a[k][p];
+                    float akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for(int k = 0; k < 3; k++)
+                {
+                    float apk = a[p][k];
+                    float aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for(int k = 0; k < 3; k++)
+                {
+                    float vkp = v[k][p];
+                    float vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    int order[3] = { 0, 1, 2 };
+    for(int i = 0; i < 2; i++)
+    {
+        for(int j = i + 1; j < 3; j++)
+        {
+            if(a[order[j]][order[j]] > a[order[i]][order[i]])
+            {
+                int temp = order[i];
+                order[i] = order[j];
+                order[j] = temp;
+            }
+        }
+    }
+
+    eigenvalues = Vec3f(a[order[0]][order[0]], a[order[1]][order[1]], a[order[2]][order[2]]);
+    if(exponent != 0)
+    {
+        eigenvalues = Vec3f(ldexpf(eigenvalues.x, exponent), ldexpf(eigenvalues.y, exponent), ldexpf(eigenvalues.z, exponent));
+    }
+    eigenvectors.SetIdentity();
+    for(int i = 0; i < 3; i++)
+    {
+        for(int k = 0; k < 3; k++)
+        {
+            eigenvectors.m[i][k] = v[k][order[i]];
+        }
+    }
+}
+
+void MathLib::EigenSymmetric3x3(const Mat4 *matrices, Vec3f *eigenvalues, Mat4 *eigenvectors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        EigenSymmetric3x3(matrices[i], eigenvalues[i], eigenvectors[i]);
+    }
+}
+
+bool MathLib::DecomposeTransform(const Mat4 &matrix, Vec3f &translation, Mat4 &rotation, Vec3f &scale)
+{
+    float r[3][3];
+    float s[3];
+    Load3x3(matrix, r);
+    for(int i = 0; i < 3; i++)
+    {
+        s[i] = sqrtf(r[i][0] * r[i][0] + r[i][1] * r[i][1] + r[i][2] * r[i][2]);
+        if(s[i] == 0.0f)
+        {
+            return false;
+        }
+    }
+    if(Determinant3x3(r) < 0.0f)
+    {
+        s[0] = -s[0];
+    }
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            r[i][j] /= s[i];
+        }
+    }
+
+    Store3x3(rotation, r);
+    translation = Vec3f(matrix.data._41, matrix.data._42, matrix.data._43);
+    scale = Vec3f(s[0], s[1], s[2]);
+    return true;
+}
+
+size_t MathLib::DecomposeTransform(const Mat4 *matrices, Vec3f *translations, Mat4 *rotations, Vec3f *scales, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_DECOMPOSE_BATCH, count);
+    size_t failed = 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(!DecomposeTransform(matrices[i], translations[i], rotations[i], scales[i]))
+        {
+            failed++;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,107 @@
+#ifndef MATH_DECOMPOSE_H
+#define MATH_DECOMPOSE_H
+
+#include <cstddef>
+#include "vec.h"
+#include "matrix.h"
+
+/*! \file decompose.h
+  \brief Contains small dense solvers and matrix decompositions.
+  Unless noted otherwise m[i][j] is treated as row i, column j of the matrix
+  and vectors are column vectors, so a solve finds x in matrix * x = b.
+  3x3 functions use the upper left part of a Mat4 and leave the rest as identity.
+  Factorizations are stated as products of these m[i][j] arrays. Mat4::operator * applies
+  its right operand first, so A * B in code computes the array product B A, and a
+  factorization matrix = Q R is reproduced in code by r * q.
+  DecomposeQR, DecomposePolar and EigenSymmetric3x3 scale their input by a power of two when its
+  entries are far from 1, so denormal and huge matrices keep full precision.
+  */
+
+namespace MathLib
+{
+    /*! Computes an LU decomposition with partial pivoting in place
+      \param matrix Matrix to decompose, receives L (unit diagonal, below) and U (on and above the diagonal)
+      \param pivot Receives the row swapped with row k at step k
+      \return false if the matrix is singular
+      */
+    bool DecomposeLU(Mat4 &matrix, int pivot[4]);
+
+    /*! Decomposes an array of matrices in place
+      \return Number of singular matrices
+      */
+    size_t DecomposeLU(Mat4 *matrices, int (*pivots)[4], size_t count);
+
+    /*! Solves a system using the result of DecomposeLU, b is replaced by the solution */
+    void SolveLU(const Mat4 &lu, const int pivot[4], Point4f &b);
+
+    /*! Solves a 4x4 system
+      \return false if the matrix is singular
+      */
+    bool Solve(const Mat4 &matrix, const Point4f &b, Point4f &x);
+
+    /*! Solves a 3x3 system
+      \return false if the matrix is singular
+      */
+    bool Solve3x3(const Mat4 &matrix, const Vec3f &b, Vec3f &x);
+
+    /*! Solves an array of 3x3 systems, every vector is replaced by its solution
+      \return Number of singular systems, their vectors are left unchanged
+      */
+    size_t Solve3x3(const Mat4 *matrices, Vec3f *vectors, size_t count);
+
+    /*! Re-orthonormalizes the rotation rows of a matrix (Gram-Schmidt), the translation row is kept */
+    void Orthonormalize(Mat4 &matrix);
+
+    /*! Re-orthonormalizes an array of matrices in place */
+    void Orthonormalize(Mat4 *matrices, size_t count);
+
+    /*! Computes a 3x3 QR decomposition (modified Gram-Schmidt), the array product Q R equals matrix,
+      in code matrix == r * q
+      \param q Receives the orthonormal factor
+      \param r Receives the upper triangular factor
+      \return false if the columns are linearly dependent
+      */
+    bool DecomposeQR(const Mat4 &matrix, Mat4 &q, Mat4 &r);
+
+    /*! Computes QR decompositions of an array of matrices
+      \return Number of matrices with linearly dependent columns, their factors are undefined
+      */
+    size_t DecomposeQR(const Mat4 *matrices, Mat4 *q, Mat4 *r, size_t count);
+
+    /*! Computes a 3x3 polar decomposition, the array product rotation stretch equals matrix,
+      in code matrix == stretch * rotation
+      \param rotation Receives the orthogonal factor, it contains a reflection when the determinant is negative
+      \param stretch Receives the symmetric factor
+      \return false if the matrix is singular
+      */
+    bool DecomposePolar(const Mat4 &matrix, Mat4 &rotation, Mat4 &stretch);
+
+    /*! Computes polar decompositions of an array of matrices
+      \return Number of singular matrices, their factors are undefined
+      */
+    size_t DecomposePolar(const Mat4 *matrices, Mat4 *rotations, Mat4 *stretches, size_t count);
+
+    /*! Computes eigenvalues and eigenvectors of a symmetric 3x3 matrix (cyclic Jacobi)
+      \param eigenvalues Receives eigenvalues in descending order
+      \param eigenvectors Receives unit eigenvectors as rows, in the order of eigenvalues.
+      The array product of row i with matrix equals eigenvalue i times row i
+      */
+    void EigenSymmetric3x3(const Mat4 &matrix, Vec3f &eigenvalues, Mat4 &eigenvectors);
+
+    /*! Computes eigenvalues and eigenvectors of an array of symmetric 3x3 matrices */
+    void EigenSymmetric3x3(const Mat4 *matrices, Vec3f *eigenvalues, Mat4 *eigenvectors, size_t count);
+
+    /*! Splits a transform built in code as translation * (rotation * scaling) back into its parts.
+      The first scale component is negative when the matrix contains a reflection.
+      Uses the library's row vector layout, the translation is read from _41, _42 and _43.
+      \return false if a scale component is zero
+      */
+    bool DecomposeTransform(const Mat4 &matrix, Vec3f &translation, Mat4 &rotation, Vec3f &scale);
+
+    /*! Splits an array of transforms
+      \return Number of transforms which could not be decomposed
+      */
+    size_t DecomposeTransform(const Mat4 *matrices, Vec3f *translations, Mat4 *rotations, Vec3f *scales, size_t count);
+}
+
+#endif
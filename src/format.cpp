@@ -0,0 +1,280 @@
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include "format.h"
+#include "profiler.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    char* Append(char *first, const char *text, size_t length)
+    {
+        memcpy(first, text, length);
+        return first + length;
+    }
+
+    const char* SkipSeparators(const char *first, const char *last)
+    {
+        while(first != last && (*first == ',' || *first == ' ' || *first == '\t' || *first == '\n' || *first == '\r'))
+        {
+            first++;
+        }
+        return first;
+    }
+}
+
+char* MathLib::FormatFloat(char *first, char *last, float value)
+{
+    to_chars_result result = to_chars(first, last, value);
+    if(result.ec != errc())
+    {
+        throw std::range_error("Buffer is too small.");
+    }
+    return result.ptr;
+}
+
+const char* MathLib::ParseFloat(const char *first, const char *last, float &value)
+{
+    first = SkipSeparators(first, last);
+    from_chars_result result = from_chars(first, last, value);
+    if(result.ec != errc())
+    {
+        throw std::invalid_argument("Malformed number in input.");
+    }
+    return result.ptr;
+}
+
+char* MathLib::FormatMat4(char *first, char *last, const Mat4 &matrix)
+{
+    if(static_cast<size_t>(last - first) < MAX_MAT4_CHARS)
+    {
+        char temp[MAX_MAT4_CHARS];
+        char *end = FormatMat4(temp, temp + MAX_MAT4_CHARS, matrix);
+        size_t length = end - temp;
+        if(length > static_cast<size_t>(last - first))
+        {
+            throw std::range_error("Buffer is too small.");
+        }
+        return Append(first, temp, length);
+    }
+
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            first = to_chars(first, last, matrix.m[i][j]).ptr;
+            first = Append(first, ", ", 2);
+        }
+        *first++ = '\n';
+    }
+    return first;
+}
+
+char* MathLib::FormatVec3(char *first, char *last, const Vec3f &vector)
+{
+    if(static_cast<size_t>(last - first) < MAX_VEC3_CHARS)
+    {
+        char temp[MAX_VEC3_CHARS];
+        char *end = FormatVec3(temp, temp + MAX_VEC3_CHARS, vector);
+        size_t length = end - temp;
+        if(length > static_cast<size_t>(last - first))
+        {
+            throw std::range_error("Buffer is too small.");
+        }
+        return Append(first, temp, length);
+    }
+
+    first = to_chars(first, last, vector.x).ptr;
+    first = Append(first, ", ", 2);
+    first = to_chars(first, last, vector.y).ptr;
+    first = Append(first, ", ", 2);
+    first = to_chars(first, last, vector.z).ptr;
+    *first++ = '\n';
+    return first;
+}
+
+size_t MathLib::FormatMat4Array(char *buffer, size_t size, const Mat4 *matrices, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_FORMAT_BATCH, count);
+    char *first = buffer;
+    char *last = buffer + size;
+    for(size_t i = 0; i < count; i++)
+    {
+        first = FormatMat4(first, last, matrices[i]);
+    }
+    return first - buffer;
+}
+
+size_t MathLib::FormatVec3Array(char *buffer, size_t size, const Vec3f *vectors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_FORMAT_BATCH, count);
+    char *first = buffer;
+    char *last = buffer + size;
+    for(size_t i = 0; i < count; i++)
+    {
+        first = FormatVec3(first, last, vectors[i]);
+    }
+    return first - buffer;
+}
+
+const char* MathLib::ParseMat4(const char *first, const char *last, Mat4 &matrix)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            first = ParseFloat(first, last, matrix.m[i][j]);
+        }
+    }
+    return SkipSeparators(first, last);
+}
+
+const char* MathLib::ParseVec3(const char *first, const char *last, Vec3f &vector)
+{
+    first = ParseFloat(first, last, vector.x);
+    first = ParseFloat(first, last, vector.y);
+    first = ParseFloat(first, last, vector.z);
+    return SkipSeparators(first, last);
+}
+
+const char* MathLib::ParseMat4Array(const char *first, const char *last, Mat4 *matrices, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PARSE_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        first = ParseMat4(first, last, matrices[i]);
+    }
+    return first;
+}
+
+const char* MathLib::ParseVec3Array(const char *first, const char *last, Vec3f *vectors, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PARSE_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        first = ParseVec3(first, last, vectors[i]);
+    }
+    return first;
+}
+
+size_t MathLib::PackMat4Array(unsigned char *buffer, size_t size, const Mat4 *matrices, size_t count)
+{
+    const size_t stride = 16 * sizeof(float);
+    if(size / stride < count)
+    {
+        throw std::range_error("Buffer is too small.");
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        memcpy(buffer + i * stride, matrices[i].GetPointer(), stride);
+    }
+    return count * stride;
+}
+
+size_t MathLib::PackVec3Array(unsigned char *buffer, size_t size, const Vec3f *vectors, size_t count)
+{
+    const size_t stride = 3 * sizeof(float);
+    if(size / stride < count)
+    {
+        throw std::range_error("Buffer is too small.");
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        float values[3] = { vectors[i].x, vectors[i].y, vectors[i].z };
+        memcpy(buffer + i * stride, values, stride);
+    }
+    return count * stride;
+}
+
+size_t MathLib::UnpackMat4Array(const unsigned char *buffer, size_t size, Mat4 *matrices, size_t count)
+{
+    const size_t stride = 16 * sizeof(float);
+    if(size / stride < count)
+    {
+        throw std::range_error("Buffer is too small.");
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        memcpy(&matrices[i].m, buffer + i * stride, stride);
+    }
+    return count * stride;
+}
+
+size_t MathLib::UnpackVec3Array(const unsigned char *buffer, size_t size, Vec3f *vectors, size_t count)
+{
+    const size_t stride = 3 * sizeof(float);
+    if(size / stride < count)
+    {
+        throw std::range_error("Buffer is too small.");
+    }
+    for(size_t i = 0; i < count; i++)
+    {
+        float values[3];
+        memcpy(values, buffer + i * stride, stride);
+        vectors[i] = Vec3f(values[0], values[1], values[2]);
+    }
+    return count * stride;
+}
+
+StreamWriter::StreamWriter(std::ostream &out, size_t capacity)
+    : out(out), buffer(0), capacity(capacity < MAX_MAT4_CHARS ? MAX_MAT4_CHARS : capacity), used(0)
+{
+    buffer = new char[this->capacity];
+}
+
+StreamWriter::~StreamWriter()
+{
+    Flush();
+    delete [] buffer;
+}
+
+void StreamWriter::Reserve(size_t size)
+{
+    if(capacity - used < size)
+    {
+        Flush();
+    }
+}
+
+StreamWriter& StreamWriter::Write(const Mat4 &matrix)
+{
+    Reserve(MAX_MAT4_CHARS);
+    used = FormatMat4(buffer + used, buffer + capacity, matrix) - buffer;
+    return *this;
+}
+
+StreamWriter& StreamWriter::Write(const Vec3f &vector)
+{
+    Reserve(MAX_VEC3_CHARS);
+    used = FormatVec3(buffer + used, buffer + capacity, vector) - buffer;
+    return *this;
+}
+
+StreamWriter& StreamWriter::Write(const Mat4 *matrices, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        Write(matrices[i]);
+    }
+    return *this;
+}
+
+StreamWriter& StreamWriter::Write(const Vec3f *vectors, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        Write(vectors[i]);
+    }
+    return *this;
+}
+
+void StreamWriter::Flush()
+{
+    if(used > 0)
+    {
+        out.write(buffer, used);
+        used = 0;
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef MATH_FORMAT_H
+#define MATH_FORMAT_H
+
+#include <ostream>
+#include <cstddef>
+#include "vec.h"
+#include "matrix.h"
+
+/*! \file format.h
+  \brief Contains fast text and binary formatters and parsers for matrices and vectors
+  */
+
+namespace MathLib
+{
+    /*! Maximum number of characters needed to write a single float in shortest round-trip form */
+    const size_t MAX_FLOAT_CHARS = 16;
+
+    /*! Maximum number of characters needed to write a Mat4 in text form */
+    const size_t MAX_MAT4_CHARS = 16 * (MAX_FLOAT_CHARS + 2) + 4;
+
+    /*! Maximum number of characters needed to write a Vec3f in text form */
+    const size_t MAX_VEC3_CHARS = 3 * (MAX_FLOAT_CHARS + 2) + 1;
+
+    /*! Writes a float in shortest round-trip form
+      \param first Beginning of the output buffer
+      \param last End of the output buffer
+      \return Pointer past the last written character
+      */
+    char* FormatFloat(char *first, char *last, float value);
+
+    /*! Parses a float written by FormatFloat, skipping leading commas and whitespace.
+      Gives back the exact bits of every value except the payload of NaN.
+      Throws std::invalid_argument for malformed input
+      \return Pointer past the last consumed character
+      */
+    const char* ParseFloat(const char *first, const char *last, float &value);
+
+    /*! Writes a matrix using the same layout as operator << (four rows of "v, v, v, v, ")
+      \return Pointer past the last written character
+      */
+    char* FormatMat4(char *first, char *last, const Mat4 &matrix);
+
+    /*! Writes a vector as a single "x, y, z" line
+      \return Pointer past the last written character
+      */
+    char* FormatVec3(char *first, char *last, const Vec3f &vector);
+
+    /*! Formats an array of matrices into a caller buffer
+      \return Number of characters written
+      */
+    size_t FormatMat4Array(char *buffer, size_t size, const Mat4 *matrices, size_t count);
+
+    /*! Formats an array of vectors into a caller buffer, one vector per line
+      \return Number of characters written
+      */
+    size_t FormatVec3Array(char *buffer, size_t size, const Vec3f *vectors, size_t count);
+
+    /*! Parses a matrix written by FormatMat4 or operator <<
+      \return Pointer past the last consumed character
+      */
+    const char* ParseMat4(const char *first, const char *last, Mat4 &matrix);
+
+    /*! Parses a vector written by FormatVec3 or operator <<
+      \return Pointer past the last consumed character
+      */
+    const char* ParseVec3(const char *first, const char *last, Vec3f &vector);
+
+    /*! Parses count matrices from a text buffer
+      \return Pointer past the last consumed character
+      */
+    const char* ParseMat4Array(const char *first, const char *last, Mat4 *matrices, size_t count);
+
+    /*! Parses count vectors from a text buffer
+      \return Pointer past the last consumed character
+      */
+    const char* ParseVec3Array(const char *first, const char *last, Vec3f *vectors, size_t count);
+
+    /*! Copies matrices into a buffer as raw floats in host byte order
+      \return Number of bytes written
+      */
+    size_t PackMat4Array(unsigned char *buffer, size_t size, const Mat4 *matrices, size_t count);
+
+    /*! Copies vectors into a buffer as raw floats in host byte order
+      \return Number of bytes written
+      */
+    size_t PackVec3Array(unsigned char *buffer, size_t size, const Vec3f *vectors, size_t count);
+
+    /*! Reads matrices written by PackMat4Array
+      \return Number of bytes consumed
+      */
+    size_t UnpackMat4Array(const unsigned char *buffer, size_t size, Mat4 *matrices, size_t count);
+
+    /*! Reads vectors written by PackVec3Array
+      \return Number of bytes consumed
+      */
+    size_t UnpackVec3Array(const unsigned char *buffer, size_t size, Vec3f *vectors, size_t count);
+
+    //! Buffered text writer
+    /*!
+      Formats matrices and vectors into an internal buffer and hands it to the stream
+      in large blocks, so the stream is never flushed per row.
+      */
+    class StreamWriter
+    {
+        public:
+            /*! Creates a writer on top of a stream
+              \param out Destination stream
+              \param capacity Size of the internal buffer in bytes
+              */
+            StreamWriter(std::ostream &out, size_t capacity = 64 * 1024);
+
+            /*! Flushes remaining data to the stream */
+            ~StreamWriter();
+
+            /*! Writes a matrix */
+            StreamWriter& Write(const Mat4 &matrix);
+
+            /*! Writes a vector */
+            StreamWriter& Write(const Vec3f &vector);
+
+            /*! Writes an array of matrices */
+            StreamWriter& Write(const Mat4 *matrices, size_t count);
+
+            /*! Writes an array of vectors */
+            StreamWriter& Write(const Vec3f *vectors, size_t count);
+
+            /*! Passes the buffered data to the stream */
+            void Flush();
+
+        private:
+            StreamWriter(const StreamWriter&);
+            void operator =(const StreamWriter&);
+
+            void Reserve(size_t size);
+
+            std::ostream &out;
+            char *buffer;
+            size_t capacity;
+            size_t used;
+    };
+}
+
+#endif
@@ -1,9 +1,11 @@
 #include <sstream>
 #include <exception>
 #include <cstdlib>
+#include <cmath>
 #include <stdexcept>
 #include "functions.h"
 #include "matrix.h"
+#include "profiler.h"
 
 using namespace MathLib;
 using namespace std;
@@ -15,6 +17,7 @@ float MathLib::DegreesToRadians(float degrees)
 
 MathLib::Mat4& MathLib::MatrixTranslation(Mat4 &matrix, float x, float y, float z)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
     matrix.SetIdentity();
     matrix.data._41 = x;
     matrix.data._42 = y;
@@ -24,6 +27,7 @@ MathLib::Mat4& MathLib::MatrixTranslation(Mat4 &matrix, float x, float y, float
 
 MathLib::Mat4& MathLib::MatrixRotationX(Mat4 &matrix, const float radians)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
     matrix.data._11 = 1.0f;
     matrix.data._12 = 0.0f;
     matrix.data._13 = 0.0f;
@@ -48,6 +52,7 @@ MathLib::Mat4& MathLib::MatrixRotationX(Mat4 &matrix, const float radians)
 
 MathLib::Mat4& MathLib::MatrixRotationY(Mat4 &matrix, const float radians)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
     matrix.data._11 = cosf(radians);
     matrix.data._12 = 0.0f;
     matrix.data._13 = -sinf(radians);
@@ -72,6 +77,7 @@ MathLib::Mat4& MathLib::MatrixRotationY(Mat4 &matrix, const float radians)
 
 MathLib::Mat4& MathLib::MatrixRotationZ(Mat4 &matrix, const float radians)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
     matrix.data._11 = cosf(radians);
     matrix.data._12 = sinf(radians);
     matrix.data._13 = 0.0f;
@@ -96,6 +102,7 @@ MathLib::Mat4& MathLib::MatrixRotationZ(Mat4 &matrix, const float radians)
 
 MathLib::Mat4& MathLib::MatrixScaling(Mat4 &matrix, float x, float y, float z)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
     matrix.data._11 = x;
     matrix.data._12 = 0.0f;
     matrix.data._13 = 0.0f;
@@ -118,6 +125,241 @@ MathLib::Mat4& MathLib::MatrixScaling(Mat4 &matrix, float x, float y, float z)
     return matrix;
 }
 
+MathLib::Mat4& MathLib::MatrixLookAt(Mat4 &matrix, const Vec3f &eye, const Vec3f &target, const Vec3f &up)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
+    Vec3f zAxis(target.x - eye.x, target.y - eye.y, target.z - eye.z);
+    zAxis.Normalize();
+    Vec3f xAxis = up.Cross(zAxis);
+    xAxis.Normalize();
+    Vec3f yAxis = zAxis.Cross(xAxis);
+
+    matrix.data._11 = xAxis.x;
+    matrix.data._12 = yAxis.x;
+    matrix.data._13 = zAxis.x;
+    matrix.data._14 = 0.0f;
+
+    matrix.data._21 = xAxis.y;
+    matrix.data._22 = yAxis.y;
+    matrix.data._23 = zAxis.y;
+    matrix.data._24 = 0.0f;
+
+    matrix.data._31 = xAxis.z;
+    matrix.data._32 = yAxis.z;
+    matrix.data._33 = zAxis.z;
+    matrix.data._34 = 0.0f;
+
+    matrix.data._41 = -xAxis.Dot(eye);
+    matrix.data._42 = -yAxis.Dot(eye);
+    matrix.data._43 = -zAxis.Dot(eye);
+    matrix.data._44 = 1.0f;
+    return matrix;
+}
+
+MathLib::Mat4& MathLib::MatrixPerspective(Mat4 &matrix, float fovY, float aspect, float zNear, float zFar, bool reversedZ)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
+    // written as negated comparisons so NaN parameters are rejected too
+    if(!(zNear > 0.0f) || !(zFar > zNear) || !(std::isfinite(aspect) && aspect != 0.0f))
+    {
+        throw std::invalid_argument("Invalid perspective parameters.");
+    }
+    if(!(fovY > 0.0f && fovY < 3.14159265358979f))
+    {
+        throw std::invalid_argument("fovY must be in (0, pi).");
+    }
+
+    float yScale = 1.0f / tanf(fovY * 0.5f);
+    float depthScale, depthOffset;
+    if(std::isinf(zFar))
+    {
+        depthScale = reversedZ ? 0.0f : 1.0f;
+        depthOffset = reversedZ ? zNear : -zNear;
+    }
+    else if(reversedZ)
+    {
+        depthScale = zNear / (zNear - zFar);
+        depthOffset = zNear * zFar / (zFar - zNear);
+    }
+    else
+    {
+        depthScale = zFar / (zFar - zNear);
+        depthOffset = -zNear * zFar / (zFar - zNear);
+    }
+
+    matrix.data._11 = yScale / aspect;
+    matrix.data._12 = 0.0f;
+    matrix.data._13 = 0.0f;
+    matrix.data._14 = 0.0f;
+
+    matrix.data._21 = 0.0f;
+    matrix.data._22 = yScale;
+    matrix.data._23 = 0.0f;
+    matrix.data._24 = 0.0f;
+
+    matrix.data._31 = 0.0f;
+    matrix.data._32 = 0.0f;
+    matrix.data._33 = depthScale;
+    matrix.data._34 = 1.0f;
+
+    matrix.data._41 = 0.0f;
+    matrix.data._42 = 0.0f;
+    matrix.data._43 = depthOffset;
+    matrix.data._44 = 0.0f;
+    return matrix;
+}
+
+MathLib::Mat4& MathLib::MatrixOrtho(Mat4 &matrix, float width, float height, float zNear, float zFar)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
+    if(width == 0.0f || height == 0.0f || zFar == zNear)
+    {
+        throw std::invalid_argument("Invalid orthographic parameters.");
+    }
+
+    matrix.data._11 = 2.0f / width;
+    matrix.data._12 = 0.0f;
+    matrix.data._13 = 0.0f;
+    matrix.data._14 = 0.0f;
+
+    matrix.data._21 = 0.0f;
+    matrix.data._22 = 2.0f / height;
+    matrix.data._23 = 0.0f;
+    matrix.data._24 = 0.0f;
+
+    matrix.data._31 = 0.0f;
+    matrix.data._32 = 0.0f;
+    matrix.data._33 = 1.0f / (zFar - zNear);
+    matrix.data._34 = 0.0f;
+
+    matrix.data._41 = 0.0f;
+    matrix.data._42 = 0.0f;
+    matrix.data._43 = zNear / (zNear - zFar);
+    matrix.data._44 = 1.0f;
+    return matrix;
+}
+
+MathLib::Mat3 MathLib::NormalMatrix(const Mat4 &matrix)
+{
+    Mat3 result;
+    NormalMatrices(&matrix, &result, 1);
+    return result;
+}
+
+void MathLib::NormalMatrices(const Mat4 *matrices, Mat3 *normals, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_NORMAL_MATRIX_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+        const float (*m)[4] = matrices[i].m;
+        float (*n)[3] = normals[i].m;
+
+        // rows of the cofactor matrix are cross products of the other two rows
+        n[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+        n[0][1] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+        n[0][2] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+        n[1][0] = m[2][1] * m[0][2] - m[2][2] * m[0][1];
+        n[1][1] = m[2][2] * m[0][0] - m[2][0] * m[0][2];
+        n[1][2] = m[2][0] * m[0][1] - m[2][1] * m[0][0];
+        n[2][0] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+        n[2][1] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+        n[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+        float det = m[0][0] * n[0][0] + m[0][1] * n[0][1] + m[0][2] * n[0][2];
+        if(det != 0.0f)
+        {
+            float invDet = 1.0f / det;
+            for(int j = 0; j < 9; j++)
+            {
+                n[j / 3][j % 3] *= invDet;
+            }
+        }
+    }
+}
+
+MathLib::Affine3x4& MathLib::MatrixTranslation(Affine3x4 &matrix, float x, float y, float z)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
+    matrix.SetIdentity();
+    matrix.data._41 = x;
+    matrix.data._42 = y;
+    matrix.data._43 = z;
+    return matrix;
+}
+
+MathLib::Affine3x4& MathLib::MatrixRotationX(Affine3x4 &matrix, const float radians)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
+    matrix.data._11 = 1.0f;
+    matrix.data._12 = 0.0f;
+    matrix.data._13 = 0.0f;
+
+    matrix.data._21 = 0.0f;
+    matrix.data._22 = cosf(radians);
+    matrix.data._23 = sinf(radians);
+
+    matrix.data._31 = 0.0f;
+    matrix.data._32 = -sinf(radians);
+    matrix.data._33 = cosf(radians);
+
+    matrix.data._41 = 0.0f;
+    matrix.data._42 = 0.0f;
+    matrix.data._43 = 0.0f;
+    return matrix;
+}
+
+MathLib::Affine3x4& MathLib::MatrixRotationY(Affine3x4 &matrix, const float radians)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
+    matrix.data._11 = cosf(radians);
+    matrix.data._12 = 0.0f;
+    matrix.data._13 = -sinf(radians);
+
+    matrix.data._21 = 0.0f;
+    matrix.data._22 = 1.0f;
+    matrix.data._23 = 0.0f;
+
+    matrix.data._31 = sinf(radians);
+    matrix.data._32 = 0.0f;
+    matrix.data._33 = cosf(radians);
+
+    matrix.data._41 = 0.0f;
+    matrix.data._42 = 0.0f;
+    matrix.data._43 = 0.0f;
+    return matrix;
+}
+
+MathLib::Affine3x4& MathLib::MatrixRotationZ(Affine3x4 &matrix, const float radians)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_ROTATION);
+    matrix.data._11 = cosf(radians);
+    matrix.data._12 = sinf(radians);
+    matrix.data._13 = 0.0f;
+
+    matrix.data._21 = -sinf(radians);
+    matrix.data._22 = cosf(radians);
+    matrix.data._23 = 0.0f;
+
+    matrix.data._31 = 0.0f;
+    matrix.data._32 = 0.0f;
+    matrix.data._33 = 1.0f;
+
+    matrix.data._41 = 0.0f;
+    matrix.data._42 = 0.0f;
+    matrix.data._43 = 0.0f;
+    return matrix;
+}
+
+MathLib::Affine3x4& MathLib::MatrixScaling(Affine3x4 &matrix, float x, float y, float z)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_MATRIX_BUILD);
+    matrix.SetIdentity();
+    matrix.data._11 = x;
+    matrix.data._22 = y;
+    matrix.data._33 = z;
+    return matrix;
+}
+
 std::ostream & MathLib::operator << (std::ostream &out, const MathLib::Mat4 &v)
 {
     for(int i = 0; i < 4; i++)
@@ -127,7 +369,7 @@ std::ostream & MathLib::operator << (std::ostream &out, const MathLib::Mat4 &v)
             out << v.m[i][j];
             out << ", ";
         }
-        out << std::endl;
+        out << '\n';
     }
     return out;
 }
@@ -174,6 +416,7 @@ MathLib::Point3f MathLib::CatmullRom(list<Point3f> &dataContainer,
         list<Point3f>::iterator &itemPos, 
         const float &time)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_CATMULL_ROM);
     if(dataContainer.size() < 4)
     {
         throw std::range_error("dataContainer must have at least 4 elements.");
@@ -199,6 +442,7 @@ MathLib::Point3f MathLib::Bezier(list<MathLib::Point3f> &dataContainer,
         list<Point3f>::iterator &itemPos, 
         const float &time)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_BEZIER);
     if(dataContainer.size() < 4)
     {
         throw std::range_error("dataContainer must have at least 4 elements.");
@@ -218,6 +462,7 @@ MathLib::Point3f MathLib::Bezier(list<MathLib::Point3f> &dataContainer,
 
 MathLib::Point3f MathLib::LinearInterpolation(list<MathLib::Point3f> &dataContainer, list<MathLib::Point3f>::iterator itemPos, const float &time)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_LINEAR_INTERPOLATION);
     MathLib::Point3f p0 = *itemPos;
     MathLib::Point3f p1 = *++itemPos;
 
@@ -3,6 +3,7 @@
 
 #include "vec.h"
 #include "matrix.h"
+#include "affine.h"
 #include <list>
 
 /*! \file functions.h
@@ -31,6 +32,45 @@ namespace MathLib
     /*! Produces a 4x4 matrix scale */
     Mat4& MatrixScaling(Mat4 &matrix, float x, float y, float z);
 
+    /*! Produces a left-handed view matrix looking from eye at target */
+    Mat4& MatrixLookAt(Mat4 &matrix, const Vec3f &eye, const Vec3f &target, const Vec3f &up);
+
+    /*! Produces a left-handed perspective projection with depth in [0, 1]
+      \param fovY Vertical field of view in radians
+      \param aspect Width divided by height
+      \param zNear Distance to the near plane
+      \param zFar Distance to the far plane, may be infinity for an infinite far plane
+      \param reversedZ Maps the near plane to depth 1 and the far plane to depth 0
+      Throws std::invalid_argument for NaN or invalid planes, a zero or non-finite aspect and fovY outside of (0, pi)
+      */
+    Mat4& MatrixPerspective(Mat4 &matrix, float fovY, float aspect, float zNear, float zFar, bool reversedZ = false);
+
+    /*! Produces a left-handed orthographic projection with depth in [0, 1] */
+    Mat4& MatrixOrtho(Mat4 &matrix, float width, float height, float zNear, float zFar);
+
+    /*! Returns the matrix transforming normals, the inverse-transpose of the upper 3x3 part.
+      A singular matrix yields its unscaled cofactor matrix, which keeps the normal directions
+      */
+    Mat3 NormalMatrix(const Mat4 &matrix);
+
+    /*! Extracts normal matrices from an array of matrices, see NormalMatrix */
+    void NormalMatrices(const Mat4 *matrices, Mat3 *normals, size_t count);
+
+    /*! Produces an affine matrix translation */
+    Affine3x4& MatrixTranslation(Affine3x4 &matrix, float x, float y, float z);
+
+    /*! Produces an affine matrix rotation on X axis */
+    Affine3x4& MatrixRotationX(Affine3x4 &matrix, const float radians);
+
+    /*! Produces an affine matrix rotation on Y axis */
+    Affine3x4& MatrixRotationY(Affine3x4 &matrix, const float radians);
+
+    /*! Produces an affine matrix rotation on Z axis */
+    Affine3x4& MatrixRotationZ(Affine3x4 &matrix, const float radians);
+
+    /*! Produces an affine matrix scale */
+    Affine3x4& MatrixScaling(Affine3x4 &matrix, float x, float y, float z);
+
     /*! Changes degrees to radians */
     float DegreesToRadians(float degrees);
 
@@ -0,0 +1,264 @@
+#include "jobs.h"
+#include "functions.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    //! State shared by the chunks of one asynchronous operation
+    template<class Result> struct ChunkedJob
+    {
+        promise<Result> done;
+        Result result;
+        atomic<size_t> remaining;
+        mutex errorLock;
+        exception_ptr error;
+        function<void(Result&)> finish;
+    };
+
+    /*! Splits [0, count) into chunks, runs work(first, last) for each on the pool and
+      fulfils the promise when the last chunk completes */
+    template<class Result> future<Result> RunChunked(ThreadPool &pool, shared_ptr<ChunkedJob<Result> > job, size_t count, size_t chunkSize,
+            CancellationToken token, function<void(size_t, size_t)> work)
+    {
+        future<Result> result = job->done.get_future();
+        chunkSize = chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE;
+        size_t chunks = (count + chunkSize - 1) / chunkSize;
+        if(chunks == 0)
+        {
+            chunks = 1;
+        }
+        job->remaining = chunks;
+
+        for(size_t c = 0; c < chunks; c++)
+        {
+            size_t first = c * chunkSize;
+            size_t last = first + chunkSize < count ? first + chunkSize : count;
+            pool.Enqueue([job, token, work, first, last]() {
+                try
+                {
+                    if(token.IsCancelled())
+                    {
+                        throw runtime_error("Job was cancelled.");
+                    }
+                    if(first < last)
+                    {
+                        work(first, last);
+                    }
+                }
+                catch(...)
+                {
+                    lock_guard<mutex> guard(job->errorLock);
+                    if(!job->error)
+                    {
+                        job->error = current_exception();
+                    }
+                }
+
+                if(job->remaining.fetch_sub(1, memory_order_acq_rel) != 1)
+                {
+                    return;
+                }
+
+                // the last chunk publishes the result
+                try
+                {
+                    if(!job->error && token.IsCancelled())
+                    {
+                        throw runtime_error("Job was cancelled.");
+                    }
+                    if(!job->error && job->finish)
+                    {
+                        job->finish(job->result);
+                    }
+                }
+                catch(...)
+                {
+                    job->error = current_exception();
+                }
+
+                if(job->error)
+                {
+                    job->done.set_exception(job->error);
+                }
+                else
+                {
+                    job->done.set_value(std::move(job->result));
+                }
+            });
+        }
+        return result;
+    }
+}
+
+CancellationToken::CancellationToken()
+    : cancelled(make_shared<atomic<bool> >(false))
+{
+}
+
+void CancellationToken::Cancel()
+{
+    cancelled->store(true, memory_order_relaxed);
+}
+
+bool CancellationToken::IsCancelled() const
+{
+    return cancelled->load(memory_order_relaxed);
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : stopping(false)
+{
+    if(threadCount == 0)
+    {
+        threadCount = thread::hardware_concurrency();
+    }
+    if(threadCount == 0)
+    {
+        threadCount = 1;
+    }
+
+    for(size_t i = 0; i < threadCount; i++)
+    {
+        workers.push_back(thread(&ThreadPool::Run, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    available.notify_all();
+    for(size_t i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return workers.size();
+}
+
+void ThreadPool::Enqueue(function<void()> task)
+{
+    {
+        lock_guard<mutex> guard(lock);
+        if(stopping)
+        {
+            throw std::logic_error("Thread pool is stopping.");
+        }
+        tasks.push_back(std::move(task));
+    }
+    available.notify_one();
+}
+
+void ThreadPool::Run()
+{
+    for(;;)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> guard(lock);
+            available.wait(guard, [this]() { return stopping || !tasks.empty(); });
+            if(tasks.empty())
+            {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+future<vector<Point3f> > MathLib::TransformPointsAsync(ThreadPool &pool, const Affine3x4 &matrix, vector<Point3f> points,
+        CancellationToken token, size_t chunkSize)
+{
+    shared_ptr<ChunkedJob<vector<Point3f> > > job = make_shared<ChunkedJob<vector<Point3f> > >();
+    job->result = std::move(points);
+    size_t count = job->result.size();
+    ChunkedJob<vector<Point3f> > *state = job.get();
+    return RunChunked<vector<Point3f> >(pool, job, count, chunkSize, token, [state, matrix](size_t first, size_t last) {
+        matrix.TransformPoints(&state->result[first], &state->result[first], last - first);
+    });
+}
+
+future<vector<Point3f> > MathLib::SampleCatmullRomAsync(ThreadPool &pool, const list<Point3f> &controlPoints, size_t samplesPerSegment,
+        CancellationToken token, size_t chunkSize)
+{
+    if(controlPoints.size() < 4)
+    {
+        throw std::range_error("controlPoints must have at least 4 elements.");
+    }
+
+    shared_ptr<list<Point3f> > points = make_shared<list<Point3f> >(controlPoints);
+    shared_ptr<ChunkedJob<vector<Point3f> > > job = make_shared<ChunkedJob<vector<Point3f> > >();
+    size_t segments = points->size();
+    job->result.resize(segments * samplesPerSegment);
+    ChunkedJob<vector<Point3f> > *state = job.get();
+
+    // a chunk covers whole segments, CatmullRom only reads the shared list
+    size_t segmentsPerChunk = samplesPerSegment > 0 ? (chunkSize + samplesPerSegment - 1) / samplesPerSegment : segments;
+    return RunChunked<vector<Point3f> >(pool, job, segments, segmentsPerChunk, token, [state, points, samplesPerSegment](size_t first, size_t last) {
+        list<Point3f>::iterator item = points->begin();
+        advance(item, first);
+        for(size_t segment = first; segment < last; segment++, item++)
+        {
+            for(size_t s = 0; s < samplesPerSegment; s++)
+            {
+                float time = float(s) / float(samplesPerSegment);
+                state->result[segment * samplesPerSegment + s] = CatmullRom(*points, item, time);
+            }
+        }
+    });
+}
+
+future<Mat4> MathLib::ComposeMatricesAsync(ThreadPool &pool, vector<Mat4> matrices, CancellationToken token, size_t chunkSize)
+{
+    chunkSize = chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE;
+    shared_ptr<vector<Mat4> > input = make_shared<vector<Mat4> >(std::move(matrices));
+    size_t chunks = (input->size() + chunkSize - 1) / chunkSize;
+    shared_ptr<vector<Mat4> > partial = make_shared<vector<Mat4> >(chunks);
+
+    shared_ptr<ChunkedJob<Mat4> > job = make_shared<ChunkedJob<Mat4> >();
+    job->finish = [partial](Mat4 &result) {
+        result.SetIdentity();
+        for(size_t i = 0; i < partial->size(); i++)
+        {
+            result = result * (*partial)[i];
+        }
+    };
+    return RunChunked<Mat4>(pool, job, input->size(), chunkSize, token, [input, partial, chunkSize](size_t first, size_t last) {
+        Mat4 product = (*input)[first];
+        for(size_t i = first + 1; i < last; i++)
+        {
+            product = product * (*input)[i];
+        }
+        (*partial)[first / chunkSize] = product;
+    });
+}
+
+future<vector<Mat4> > MathLib::MultiplyMatricesAsync(ThreadPool &pool, vector<Mat4> left, vector<Mat4> right,
+        CancellationToken token, size_t chunkSize)
+{
+    if(left.size() != right.size())
+    {
+        throw std::invalid_argument("Matrix arrays must have the same size.");
+    }
+
+    shared_ptr<vector<Mat4> > rightInput = make_shared<vector<Mat4> >(std::move(right));
+    shared_ptr<ChunkedJob<vector<Mat4> > > job = make_shared<ChunkedJob<vector<Mat4> > >();
+    job->result = std::move(left);
+    size_t count = job->result.size();
+    ChunkedJob<vector<Mat4> > *state = job.get();
+    return RunChunked<vector<Mat4> >(pool, job, count, chunkSize, token, [state, rightInput](size_t first, size_t last) {
+        for(size_t i = first; i < last; i++)
+        {
+            state->result[i] = state->result[i] * (*rightInput)[i];
+        }
+    });
+}
@@ -0,0 +1,231 @@
+#ifndef MATH_JOBS_H
+#define MATH_JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "vec.h"
+#include "matrix.h"
+#include "affine.h"
+
+/*! \file jobs.h
+  \brief Contains a thread pool, asynchronous batch operations and a chunked pipeline.
+  Results are delivered through std::future. Cancelled jobs complete with std::runtime_error.
+  Never wait on a future from a pool thread, the pool could run out of threads.
+  */
+
+namespace MathLib
+{
+    /*! Default number of elements processed by a single pool task */
+    const size_t DEFAULT_CHUNK_SIZE = 4096;
+
+    //! Shared cancellation flag
+    /*!
+      Copies refer to the same flag, so a copy kept by the caller cancels
+      every job which received another copy.
+      */
+    class CancellationToken
+    {
+        public:
+            /*! Creates a new flag which is not cancelled */
+            CancellationToken();
+
+            /*! Requests cancellation, jobs stop at the next chunk boundary */
+            void Cancel();
+
+            /*! Returns true if cancellation was requested */
+            bool IsCancelled() const;
+
+        private:
+            std::shared_ptr<std::atomic<bool> > cancelled;
+    };
+
+    //! Fixed-size pool of worker threads
+    /*!
+      Tasks run in submission order. The destructor finishes queued tasks
+      before joining the workers.
+      */
+    class ThreadPool
+    {
+        public:
+            /*! Starts threadCount workers, 0 uses the number of hardware threads */
+            explicit ThreadPool(size_t threadCount = 0);
+
+            /*! Runs the remaining tasks and joins the workers */
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator =(const ThreadPool&) = delete;
+
+            /*! Returns number of workers */
+            size_t GetThreadCount() const;
+
+            /*! Queues a task without a result */
+            void Enqueue(std::function<void()> task);
+
+            /*! Queues a task, the future receives its result or exception */
+            template<class Function> std::future<typename std::invoke_result<Function>::type> Submit(Function function)
+            {
+                typedef typename std::invoke_result<Function>::type Result;
+                std::shared_ptr<std::packaged_task<Result()> > task = std::make_shared<std::packaged_task<Result()> >(std::move(function));
+                std::future<Result> result = task->get_future();
+                Enqueue([task]() { (*task)(); });
+                return result;
+            }
+
+        private:
+            void Run();
+
+            std::vector<std::thread> workers;
+            std::deque<std::function<void()> > tasks;
+            std::mutex lock;
+            std::condition_variable available;
+            bool stopping;
+    };
+
+    /*! Transforms points by an affine matrix, chunks run in parallel */
+    std::future<std::vector<Point3f> > TransformPointsAsync(ThreadPool &pool, const Affine3x4 &matrix, std::vector<Point3f> points,
+            CancellationToken token = CancellationToken(), size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /*! Samples a closed CatmullRom spline, samplesPerSegment points per control point, chunks of segments run in parallel */
+    std::future<std::vector<Point3f> > SampleCatmullRomAsync(ThreadPool &pool, const std::list<Point3f> &controlPoints, size_t samplesPerSegment,
+            CancellationToken token = CancellationToken(), size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /*! Computes matrices[0] * matrices[1] * ... * matrices[n - 1], partial products run in parallel.
+      The grouping differs from a sequential loop, so results may differ in the last bits
+      */
+    std::future<Mat4> ComposeMatricesAsync(ThreadPool &pool, std::vector<Mat4> matrices,
+            CancellationToken token = CancellationToken(), size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    /*! Computes left[i] * right[i] for every pair, throws std::invalid_argument if the sizes differ */
+    std::future<std::vector<Mat4> > MultiplyMatricesAsync(ThreadPool &pool, std::vector<Mat4> left, std::vector<Mat4> right,
+            CancellationToken token = CancellationToken(), size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    //! Ordered pipeline processing chunks on a thread pool
+    /*!
+      A producer pushes chunks as they are loaded and a consumer pops results in
+      the same order, so computation of one chunk overlaps with loading of the next.
+      At most capacity chunks are in flight, Push blocks until the consumer catches up.
+      \code
+      ThreadPool pool;
+      ChunkPipeline<std::vector<Point3f>, std::vector<Point3f> > pipeline(pool,
+          [matrix](const std::vector<Point3f> &in) { std::vector<Point3f> out(in.size()); matrix.TransformPoints(in.data(), out.data(), in.size()); return out; }, 4);
+      // loader thread: pipeline.Push(chunk) for every chunk, then pipeline.Close()
+      // writer thread: while(pipeline.Pop(result)) { write result }
+      \endcode
+      */
+    template<class In, class Out> class ChunkPipeline
+    {
+        public:
+            typedef std::function<Out(const In&)> Stage;
+
+            /*! Creates a pipeline running stage on every chunk */
+            ChunkPipeline(ThreadPool &pool, Stage stage, size_t capacity, CancellationToken token = CancellationToken())
+                : pool(pool), stage(stage), capacity(capacity > 0 ? capacity : 1), token(token), closed(false)
+            {
+            }
+
+            /*! Cancels the pipeline and waits for chunks already running */
+            ~ChunkPipeline()
+            {
+                Cancel();
+                std::unique_lock<std::mutex> guard(lock);
+                for(size_t i = 0; i < pending.size(); i++)
+                {
+                    pending[i].wait();
+                }
+            }
+
+            ChunkPipeline(const ChunkPipeline&) = delete;
+            ChunkPipeline& operator =(const ChunkPipeline&) = delete;
+
+            /*! Queues a chunk, blocks while capacity chunks are in flight
+              \return false if the pipeline was cancelled or closed
+              */
+            bool Push(In chunk)
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [this]() { return pending.size() < capacity || closed || token.IsCancelled(); });
+                if(closed || token.IsCancelled())
+                {
+                    return false;
+                }
+
+                Stage work = stage;
+                CancellationToken flag = token;
+                std::shared_ptr<In> input = std::make_shared<In>(std::move(chunk));
+                pending.push_back(pool.Submit([work, flag, input]() {
+                    if(flag.IsCancelled())
+                    {
+                        throw std::runtime_error("Job was cancelled.");
+                    }
+                    return work(*input);
+                }));
+                changed.notify_all();
+                return true;
+            }
+
+            /*! Receives the oldest chunk, blocks until it is processed. Rethrows exceptions of the stage
+              \return false if the pipeline was cancelled, or closed and drained
+              */
+            bool Pop(Out &result)
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                changed.wait(guard, [this]() { return !pending.empty() || closed || token.IsCancelled(); });
+                if(pending.empty() || token.IsCancelled())
+                {
+                    return false;
+                }
+
+                std::future<Out> next = std::move(pending.front());
+                pending.pop_front();
+                changed.notify_all();
+                guard.unlock();
+                result = next.get();
+                return true;
+            }
+
+            /*! Marks the end of input, Pop returns false once the remaining chunks are received */
+            void Close()
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                closed = true;
+                changed.notify_all();
+            }
+
+            /*! Cancels the pipeline, wakes blocked Push and Pop calls */
+            void Cancel()
+            {
+                token.Cancel();
+                std::lock_guard<std::mutex> guard(lock);
+                changed.notify_all();
+            }
+
+            /*! Returns true if the pipeline was cancelled */
+            bool IsCancelled() const
+            {
+                return token.IsCancelled();
+            }
+
+        private:
+            ThreadPool &pool;
+            Stage stage;
+            size_t capacity;
+            CancellationToken token;
+            bool closed;
+            std::deque<std::future<Out> > pending;
+            std::mutex lock;
+            std::condition_variable changed;
+    };
+}
+
+#endif
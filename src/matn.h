@@ -0,0 +1,215 @@
+#ifndef MATN_H
+#define MATN_H
+
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include "vecn.h"
+
+/*! \file matn.h
+  \brief Contains RxC Matrix template declaration and definition.
+  Mat<4, 4, float> is specialized in matrix.h and keeps the original Mat4 interface.
+  */
+
+namespace MathLib
+{
+    //! RxC Matrix template class
+    /*!
+      Follows the Mat4 conventions: vectors are rows and A * B applies B first,
+      so a vector is transformed as v * (A * B) = (v * B) * A.
+      Loops are unrolled at compile time.
+      */
+    template<int R, int C, typename T> class Mat
+    {
+        public:
+            T m[R][C];
+
+            /*! Default constructor. Sets all fields to zeroes */
+            Mat()
+            {
+                memset(m, 0, sizeof(m));
+            }
+
+            /*! Constructor which gets values for matrix fields, row by row */
+            template<typename... Args, typename = typename std::enable_if<sizeof...(Args) == R * C && (R * C > 1)>::type>
+            Mat(Args... args)
+            {
+                const T values[R * C] = { static_cast<T>(args)... };
+                memcpy(m, values, sizeof(m));
+            }
+
+            /*! Helper operator which allows writing matrix value to the output stream */
+            friend std::ostream & operator << (std::ostream &out, const Mat &matrix)
+            {
+                for(int i = 0; i < R; i++)
+                {
+                    for(int j = 0; j < C; j++)
+                    {
+                        out << matrix.m[i][j] << ", ";
+                    }
+                    out << '\n';
+                }
+                return out;
+            }
+
+            /*! Helper operator which allows multiplying scalar by a matrix */
+            friend Mat operator *(const T &scalar, const Mat &matrix)
+            {
+                return matrix * scalar;
+            }
+
+            /*! Add a matrix to another matrix */
+            Mat operator +(const Mat &matrix) const
+            {
+                Mat result(*this);
+                result += matrix;
+                return result;
+            }
+
+            /*! Add a matrix to another matrix (makes modifications to the matrix) */
+            const Mat& operator +=(const Mat &matrix)
+            {
+                Unroll<0, R * C>::Apply([&](int i) { m[i / C][i % C] += matrix.m[i / C][i % C]; });
+                return *this;
+            }
+
+            /*! Subtracts a matrix from another matrix */
+            Mat operator -(const Mat &matrix) const
+            {
+                Mat result(*this);
+                Unroll<0, R * C>::Apply([&](int i) { result.m[i / C][i % C] -= matrix.m[i / C][i % C]; });
+                return result;
+            }
+
+            /*! Multiplies the matrix by a scalar value */
+            Mat operator *(const T &scalar) const
+            {
+                Mat result;
+                Unroll<0, R * C>::Apply([&](int i) { result.m[i / C][i % C] = m[i / C][i % C] * scalar; });
+                return result;
+            }
+
+            /*! Multiplies a matrix by another matrix, the argument is applied first */
+            template<int K> Mat<K, C, T> operator *(const Mat<K, R, T> &matrix) const
+            {
+                Mat<K, C, T> result;
+                Unroll<0, K * C>::Apply([&](int index) {
+                    const int i = index / C;
+                    const int j = index % C;
+                    T sum = 0;
+                    Unroll<0, R>::Apply([&](int k) { sum += matrix.m[i][k] * m[k][j]; });
+                    result.m[i][j] = sum;
+                });
+                return result;
+            }
+
+            /*! Returns true if two matrices are equal, compared element by element so that 0 equals -0 and NaN equals nothing */
+            bool operator ==(const Mat &matrix) const
+            {
+                bool equal = true;
+                Unroll<0, R * C>::Apply([&](int i) { equal = equal && m[i / C][i % C] == matrix.m[i / C][i % C]; });
+                return equal;
+            }
+
+            /*! Check if it is an identity matrix */
+            bool IsIdentity() const
+            {
+                static_assert(R == C, "Only square matrices have an identity");
+                bool identity = true;
+                Unroll<0, R * C>::Apply([&](int i) { identity = identity && m[i / C][i % C] == (i / C == i % C ? 1 : 0); });
+                return identity;
+            }
+
+            /*! Set the matrix to the identity */
+            void SetIdentity()
+            {
+                static_assert(R == C, "Only square matrices have an identity");
+                Unroll<0, R * C>::Apply([&](int i) { m[i / C][i % C] = (i / C == i % C ? 1 : 0); });
+            }
+
+            /*! Return transposed matrix */
+            Mat<C, R, T> Transposed() const
+            {
+                Mat<C, R, T> result;
+                Unroll<0, R * C>::Apply([&](int i) { result.m[i % C][i / C] = m[i / C][i % C]; });
+                return result;
+            }
+
+            /*! Calculates the determinant, available for 2x2 and 3x3 matrices */
+            T Determinant() const
+            {
+                static_assert(R == C && (R == 2 || R == 3), "Determinant is implemented for 2x2 and 3x3 matrices");
+                if constexpr(R == 2)
+                {
+                    return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                }
+                else
+                {
+                    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                         - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                         + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+                }
+            }
+
+            /*! Returns inverted matrix, available for 2x2 and 3x3 matrices. Throws domain_error when the matrix is singular */
+            Mat Inverted() const
+            {
+                T det = Determinant();
+                if(det == 0)
+                {
+                    throw std::domain_error("Matrix is singular.");
+                }
+                T invDet = static_cast<T>(1) / det;
+                Mat result;
+                if constexpr(R == 2)
+                {
+                    result.m[0][0] = m[1][1] * invDet;
+                    result.m[0][1] = -m[0][1] * invDet;
+                    result.m[1][0] = -m[1][0] * invDet;
+                    result.m[1][1] = m[0][0] * invDet;
+                }
+                else
+                {
+                    result.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) * invDet;
+                    result.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+                    result.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+                    result.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) * invDet;
+                    result.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+                    result.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+                    result.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) * invDet;
+                    result.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+                    result.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+                }
+                return result;
+            }
+
+            /*! Returns value by a row and a column */
+            T GetValue(const int& row, const int& col) const
+            {
+                return m[row][col];
+            }
+
+            /*! Returns pointer on the begining of a matrix */
+            const T* GetPointer() const
+            {
+                return &m[0][0];
+            }
+    };
+
+    /*! Transforms a row vector by a matrix, v * M */
+    template<int R, int C, typename T> Vec<C, T> operator *(const Vec<R, T> &v, const Mat<R, C, T> &matrix)
+    {
+        Vec<C, T> result;
+        Unroll<0, C>::Apply([&](int j) {
+            T sum = 0;
+            Unroll<0, R>::Apply([&](int k) { sum += v[k] * matrix.m[k][j]; });
+            result[j] = sum;
+        });
+        return result;
+    }
+
+    typedef Mat<2, 2, float> Mat2;	//!< 2x2 Matrix of floats
+    typedef Mat<3, 3, float> Mat3;	//!< 3x3 Matrix of floats
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "matrix.h"
 #include "functions.h"
+#include "profiler.h"
 #include <cstring>
 
 using namespace MathLib;
@@ -9,12 +10,12 @@ float Mat4::GetValue(const int& row, const int& col) const
     return m[row][col];
 }
 
-Mat4::Mat4()
+Mat4::Mat()
 {
     memset(&this->m, 0, 16 * sizeof(float));
 }
 
-Mat4::Mat4(float _11, float _12, float _13, float _14,
+Mat4::Mat(float _11, float _12, float _13, float _14,
         float _21, float _22, float _23, float _24,
         float _31, float _32, float _33, float _34,
         float _41, float _42, float _43, float _44)
@@ -82,8 +83,25 @@ const Mat4& Mat4::operator +=(const Mat4& matrix)
 
 Mat4 Mat4::operator *(const Mat4& matrix)
 {
+    MATHLIB_PROFILE_KERNEL(PROFILE_MAT4_MULTIPLY);
     Mat4 result;
 
+#ifdef MATHLIB_SSE
+    // row i of the result is sum_k matrix.m[i][k] * this->m[k], summed in the same order as the scalar code
+    __m128 row0 = _mm_loadu_ps(this->m[0]);
+    __m128 row1 = _mm_loadu_ps(this->m[1]);
+    __m128 row2 = _mm_loadu_ps(this->m[2]);
+    __m128 row3 = _mm_loadu_ps(this->m[3]);
+    for(int i = 0; i < 4; i++)
+    {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(matrix.m[i][0]), row0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(matrix.m[i][1]), row1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(matrix.m[i][2]), row2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(matrix.m[i][3]), row3));
+        _mm_storeu_ps(result.m[i], r);
+    }
+    return result;
+#else
     result.data._11 = this->data._11 * matrix.data._11 + this->data._21 * matrix.data._12 + this->data._31 * matrix.data._13 + this->data._41 * matrix.data._14;
     result.data._12 = this->data._12 * matrix.data._11 + this->data._22 * matrix.data._12 + this->data._32 * matrix.data._13 + this->data._42 * matrix.data._14;
     result.data._13 = this->data._13 * matrix.data._11 + this->data._23 * matrix.data._12 + this->data._33 * matrix.data._13 + this->data._43 * matrix.data._14;
@@ -105,6 +123,7 @@ Mat4 Mat4::operator *(const Mat4& matrix)
     result.data._44 = this->data._14 * matrix.data._41 + this->data._24 * matrix.data._42 + this->data._34 * matrix.data._43 + this->data._44 * matrix.data._44;
 
     return result;
+#endif
 }
 
 bool Mat4::IsIdentity() const
@@ -3,6 +3,7 @@
 
 #include <sstream>
 #include <cmath>
+#include "matn.h"
 
 /*! \file matrix.h
   \brief Contains 4x4 Matrix declaration
@@ -10,12 +11,16 @@
 
 namespace MathLib
 {
+    template<> class Mat<4, 4, float>;
+    typedef Mat<4, 4, float> Mat4;	//!< 4x4 Matrix of floats
+
     //! 4x4 Matrix class
     /*!
       Allows mathematical operations on a 4x4 Matrix.
       Includes several operators and basic functions such as inversion and transposition.
+      Specialization of the Mat template, available as Mat4.
       */
-    class Mat4
+    template<> class Mat<4, 4, float>
     {
         public:
             union
@@ -31,10 +36,10 @@ namespace MathLib
             };
 
             /*! Default constructor */
-            Mat4();
+            Mat();
 
             /*! Constructor which gets values for matrix fields */
-            Mat4(float _11, float _12, float _13, float _14,
+            Mat(float _11, float _12, float _13, float _14,
                     float _21, float _22, float _23, float _24,
                     float _31, float _32, float _33, float _34,
                     float _41, float _42, float _43, float _44);
@@ -0,0 +1,199 @@
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include <sstream>
+#include "profiler.h"
+#include "simd.h"
+
+// the time stamp counter only exists on x86, other targets keep steady_clock
+#if defined(MATHLIB_PROFILE_RDTSC) && defined(MATHLIB_X86)
+#define MATHLIB_USE_RDTSC
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const char* KERNEL_NAMES[PROFILE_KERNEL_COUNT] =
+    {
+        "mat4_multiply",
+        "vec3_transform",
+        "matrix_rotation",
+        "matrix_build",
+        "catmull_rom",
+        "bezier",
+        "linear_interpolation",
+        "affine_multiply",
+        "affine_transform_batch",
+        "homogeneous_transform_batch",
+        "clip_flags_batch",
+        "perspective_divide_batch",
+        "format_batch",
+        "parse_batch",
+        "track_compress",
+        "track_decompress",
+        "decompose_batch",
+        "normal_matrix_batch",
+        "color_batch",
+        "srgb_batch",
+        "pack_batch"
+    };
+
+    //! Counters of live threads, totals of finished threads and the reset baseline
+    struct Registry
+    {
+        mutex lock;
+        vector<Profiling::ThreadCounters*> threads;
+        KernelStats retired[PROFILE_KERNEL_COUNT];
+        KernelStats baseline[PROFILE_KERNEL_COUNT];
+
+        Registry()
+        {
+            fill(&retired[0], &retired[0] + PROFILE_KERNEL_COUNT, KernelStats());
+            fill(&baseline[0], &baseline[0] + PROFILE_KERNEL_COUNT, KernelStats());
+        }
+
+        void Sum(KernelStats totals[PROFILE_KERNEL_COUNT])
+        {
+            for(int k = 0; k < PROFILE_KERNEL_COUNT; k++)
+            {
+                totals[k] = retired[k];
+                for(size_t t = 0; t < threads.size(); t++)
+                {
+                    uint64_t counted = threads[t]->counts[k].load(memory_order_relaxed);
+                    totals[k].calls += counted + threads[t]->calls[k].load(memory_order_relaxed);
+                    totals[k].items += counted + threads[t]->items[k].load(memory_order_relaxed);
+                    totals[k].ticks += threads[t]->ticks[k].load(memory_order_relaxed);
+                }
+            }
+        }
+    };
+
+    Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    //! Registers thread counters on construction and folds them into the totals on thread exit
+    class ThreadRegistration
+    {
+        public:
+            ThreadRegistration()
+            {
+                for(int k = 0; k < PROFILE_KERNEL_COUNT; k++)
+                {
+                    counters.counts[k].store(0, memory_order_relaxed);
+                    counters.calls[k].store(0, memory_order_relaxed);
+                    counters.items[k].store(0, memory_order_relaxed);
+                    counters.ticks[k].store(0, memory_order_relaxed);
+                }
+                Registry &registry = GetRegistry();
+                lock_guard<mutex> guard(registry.lock);
+                registry.threads.push_back(&counters);
+            }
+
+            ~ThreadRegistration()
+            {
+                Profiling::threadCounters = 0;
+                Registry &registry = GetRegistry();
+                lock_guard<mutex> guard(registry.lock);
+                for(int k = 0; k < PROFILE_KERNEL_COUNT; k++)
+                {
+                    uint64_t counted = counters.counts[k].load(memory_order_relaxed);
+                    registry.retired[k].calls += counted + counters.calls[k].load(memory_order_relaxed);
+                    registry.retired[k].items += counted + counters.items[k].load(memory_order_relaxed);
+                    registry.retired[k].ticks += counters.ticks[k].load(memory_order_relaxed);
+                }
+                registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), &counters), registry.threads.end());
+            }
+
+            Profiling::ThreadCounters counters;
+    };
+
+    double MeasureTicksPerSecond()
+    {
+#ifdef MATHLIB_PROFILE_RDTSC
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        uint64_t startTicks = Profiling::ReadTicks();
+        while(chrono::steady_clock::now() - start < chrono::milliseconds(10))
+        {
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        return (Profiling::ReadTicks() - startTicks) / seconds;
+#else
+        return 1e9;
+#endif
+    }
+}
+
+Profiling::ThreadCounters& Profiling::RegisterThread()
+{
+    static thread_local ThreadRegistration registration;
+    threadCounters = &registration.counters;
+    return registration.counters;
+}
+
+uint64_t Profiling::ReadTicks()
+{
+#ifdef MATHLIB_USE_RDTSC
+    return __rdtsc();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+const char* MathLib::GetKernelName(ProfileKernel kernel)
+{
+    return kernel >= 0 && kernel < PROFILE_KERNEL_COUNT ? KERNEL_NAMES[kernel] : "unknown";
+}
+
+ProfileSnapshot MathLib::GetProfileSnapshot()
+{
+    static const double ticksPerSecond = MeasureTicksPerSecond();
+
+    ProfileSnapshot snapshot;
+    Registry &registry = GetRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    registry.Sum(snapshot.kernels);
+    for(int k = 0; k < PROFILE_KERNEL_COUNT; k++)
+    {
+        snapshot.kernels[k].calls -= registry.baseline[k].calls;
+        snapshot.kernels[k].items -= registry.baseline[k].items;
+        snapshot.kernels[k].ticks -= registry.baseline[k].ticks;
+    }
+    snapshot.ticksPerSecond = ticksPerSecond;
+    return snapshot;
+}
+
+void MathLib::ResetProfile()
+{
+    Registry &registry = GetRegistry();
+    lock_guard<mutex> guard(registry.lock);
+    registry.Sum(registry.baseline);
+}
+
+std::string MathLib::ProfileToJson(const ProfileSnapshot &snapshot)
+{
+    ostringstream out;
+    out << "{\"ticksPerSecond\": " << snapshot.ticksPerSecond << ", \"kernels\": {";
+    for(int k = 0; k < PROFILE_KERNEL_COUNT; k++)
+    {
+        const KernelStats &stats = snapshot.kernels[k];
+        out << (k > 0 ? ", " : "") << "\"" << KERNEL_NAMES[k] << "\": {"
+            << "\"calls\": " << stats.calls
+            << ", \"items\": " << stats.items
+            << ", \"ticks\": " << stats.ticks
+            << ", \"seconds\": " << (snapshot.ticksPerSecond > 0.0 ? stats.ticks / snapshot.ticksPerSecond : 0.0)
+            << "}";
+    }
+    out << "}}";
+    return out.str();
+}
@@ -0,0 +1,154 @@
+#ifndef MATH_PROFILER_H
+#define MATH_PROFILER_H
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+/*! \file profiler.h
+  \brief Contains opt-in instrumentation of library kernels.
+  Define MATHLIB_PROFILE to enable the hooks, otherwise they compile to nothing.
+  Batch functions are always timed when profiling is enabled. Single-element kernels
+  such as Mat4::operator * are only counted, define MATHLIB_PROFILE_TIME_KERNELS to time
+  them as well. Define MATHLIB_PROFILE_RDTSC to read the x86 time stamp counter instead
+  of std::chrono::steady_clock, other targets ignore it.
+  */
+
+namespace MathLib
+{
+    /*! Instrumented library kernels */
+    enum ProfileKernel
+    {
+        PROFILE_MAT4_MULTIPLY,
+        PROFILE_VEC3_TRANSFORM,
+        PROFILE_MATRIX_ROTATION,
+        PROFILE_MATRIX_BUILD,
+        PROFILE_CATMULL_ROM,
+        PROFILE_BEZIER,
+        PROFILE_LINEAR_INTERPOLATION,
+        PROFILE_AFFINE_MULTIPLY,
+        PROFILE_AFFINE_TRANSFORM_BATCH,
+        PROFILE_HOMOGENEOUS_TRANSFORM_BATCH,
+        PROFILE_CLIP_FLAGS_BATCH,
+        PROFILE_PERSPECTIVE_DIVIDE_BATCH,
+        PROFILE_FORMAT_BATCH,
+        PROFILE_PARSE_BATCH,
+        PROFILE_TRACK_COMPRESS,
+        PROFILE_TRACK_DECOMPRESS,
+        PROFILE_DECOMPOSE_BATCH,
+        PROFILE_NORMAL_MATRIX_BATCH,
+        PROFILE_COLOR_BATCH,
+        PROFILE_SRGB_BATCH,
+        PROFILE_PACK_BATCH,
+        PROFILE_KERNEL_COUNT
+    };
+
+    /*! Accumulated statistics of a single kernel */
+    struct KernelStats
+    {
+        uint64_t calls;	//!< number of calls
+        uint64_t items;	//!< number of processed elements, equal to calls for single-element kernels
+        uint64_t ticks;	//!< time spent in timed calls, in ticks
+    };
+
+    /*! Statistics of all kernels summed over all threads */
+    struct ProfileSnapshot
+    {
+        KernelStats kernels[PROFILE_KERNEL_COUNT];
+        double ticksPerSecond;
+    };
+
+    /*! Returns a short snake_case name of a kernel */
+    const char* GetKernelName(ProfileKernel kernel);
+
+    /*! Returns statistics collected since the start or the last ResetProfile call */
+    ProfileSnapshot GetProfileSnapshot();
+
+    /*! Starts a new measurement period */
+    void ResetProfile();
+
+    /*! Writes a snapshot as a JSON object */
+    std::string ProfileToJson(const ProfileSnapshot &snapshot);
+
+    namespace Profiling
+    {
+        //! Counters owned by a single thread
+        /*!
+          Only the owning thread writes the counters, other threads read them
+          when a snapshot is taken, so relaxed atomics are enough.
+          */
+        struct ThreadCounters
+        {
+            std::atomic<uint64_t> counts[PROFILE_KERNEL_COUNT];	//!< untimed single-element calls, each adds one call and one item
+            std::atomic<uint64_t> calls[PROFILE_KERNEL_COUNT];
+            std::atomic<uint64_t> items[PROFILE_KERNEL_COUNT];
+            std::atomic<uint64_t> ticks[PROFILE_KERNEL_COUNT];
+        };
+
+        /*! Counters of the calling thread, null until the thread is registered.
+          Constant initialization lets hooks read it inline, without a call into profiler.cpp
+          */
+        inline thread_local ThreadCounters *threadCounters = 0;
+
+        /*! Registers the calling thread and returns its counters */
+        ThreadCounters& RegisterThread();
+
+        /*! Returns counters of the calling thread, registering it on first use */
+        inline ThreadCounters& GetThreadCounters()
+        {
+            ThreadCounters *counters = threadCounters;
+            return counters ? *counters : RegisterThread();
+        }
+
+        /*! Reads the current time in ticks */
+        uint64_t ReadTicks();
+
+        inline void Add(std::atomic<uint64_t> &counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        /*! Counts a single-element call, a single counter is updated to keep hot kernels cheap */
+        inline void Count(ProfileKernel kernel)
+        {
+            Add(GetThreadCounters().counts[kernel], 1);
+        }
+
+        //! Counts and times the enclosing scope
+        class ScopedTimer
+        {
+            public:
+                ScopedTimer(ProfileKernel kernel, uint64_t items) : kernel(kernel), items(items), start(ReadTicks())
+                {
+                }
+
+                ~ScopedTimer()
+                {
+                    uint64_t elapsed = ReadTicks() - start;
+                    ThreadCounters &counters = GetThreadCounters();
+                    Add(counters.calls[kernel], 1);
+                    Add(counters.items[kernel], items);
+                    Add(counters.ticks[kernel], elapsed);
+                }
+
+            private:
+                ProfileKernel kernel;
+                uint64_t items;
+                uint64_t start;
+        };
+    }
+}
+
+#ifdef MATHLIB_PROFILE
+#define MATHLIB_PROFILE_BATCH(kernel, items) MathLib::Profiling::ScopedTimer mathlibProfileTimer((kernel), (items))
+#ifdef MATHLIB_PROFILE_TIME_KERNELS
+#define MATHLIB_PROFILE_KERNEL(kernel) MathLib::Profiling::ScopedTimer mathlibProfileTimer((kernel), 1)
+#else
+#define MATHLIB_PROFILE_KERNEL(kernel) MathLib::Profiling::Count(kernel)
+#endif
+#else
+#define MATHLIB_PROFILE_BATCH(kernel, items) ((void)0)
+#define MATHLIB_PROFILE_KERNEL(kernel) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+#include "projection.h"
+#include "simd.h"
+#include "profiler.h"
+
+using namespace MathLib;
+
+namespace
+{
+    const unsigned char LOWER_FLAGS[8] =
+    {
+        0, CLIP_LEFT, CLIP_BOTTOM, CLIP_LEFT | CLIP_BOTTOM,
+        CLIP_NEAR, CLIP_LEFT | CLIP_NEAR, CLIP_BOTTOM | CLIP_NEAR, CLIP_LEFT | CLIP_BOTTOM | CLIP_NEAR
+    };
+
+    const unsigned char UPPER_FLAGS[8] =
+    {
+        0, CLIP_RIGHT, CLIP_TOP, CLIP_RIGHT | CLIP_TOP,
+        CLIP_FAR, CLIP_RIGHT | CLIP_FAR, CLIP_TOP | CLIP_FAR, CLIP_RIGHT | CLIP_TOP | CLIP_FAR
+    };
+
+#ifdef MATHLIB_SSE
+    inline __m128 TransformRow(const __m128 rows[4], const Point3f &point)
+    {
+        // same order as the scalar code: x * row0 + y * row1 + z * row2 + row3
+        __m128 result = _mm_mul_ps(_mm_set1_ps(point.x), rows[0]);
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(point.y), rows[1]));
+        result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(point.z), rows[2]));
+        return _mm_add_ps(result, rows[3]);
+    }
+
+    inline unsigned char GetClipFlags(__m128 v)
+    {
+        __m128 w = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+        __m128 lower = _mm_shuffle_ps(_mm_sub_ps(_mm_setzero_ps(), w), _mm_setzero_ps(), _MM_SHUFFLE(0, 0, 0, 0));
+        int below = _mm_movemask_ps(_mm_cmplt_ps(v, lower)) & 7;
+        int above = _mm_movemask_ps(_mm_cmpgt_ps(v, w)) & 7;
+        return LOWER_FLAGS[below] | UPPER_FLAGS[above];
+    }
+#else
+    inline unsigned char GetClipFlags(const Point4f &v)
+    {
+        int below = (v.x < -v.w ? 1 : 0) | (v.y < -v.w ? 2 : 0) | (v.z < 0.0f ? 4 : 0);
+        int above = (v.x > v.w ? 1 : 0) | (v.y > v.w ? 2 : 0) | (v.z > v.w ? 4 : 0);
+        return LOWER_FLAGS[below] | UPPER_FLAGS[above];
+    }
+#endif
+}
+
+Point4f MathLib::TransformHomogeneous(const Mat4 &matrix, const Point3f &point)
+{
+    return Point4f(point.x * matrix.data._11 + point.y * matrix.data._21 + point.z * matrix.data._31 + matrix.data._41,
+            point.x * matrix.data._12 + point.y * matrix.data._22 + point.z * matrix.data._32 + matrix.data._42,
+            point.x * matrix.data._13 + point.y * matrix.data._23 + point.z * matrix.data._33 + matrix.data._43,
+            point.x * matrix.data._14 + point.y * matrix.data._24 + point.z * matrix.data._34 + matrix.data._44);
+}
+
+void MathLib::TransformHomogeneous(const Mat4 &matrix, const Point3f *in, Point4f *out, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_HOMOGENEOUS_TRANSFORM_BATCH, count);
+#ifdef MATHLIB_SSE
+    const __m128 rows[4] = { _mm_loadu_ps(matrix.m[0]), _mm_loadu_ps(matrix.m[1]), _mm_loadu_ps(matrix.m[2]), _mm_loadu_ps(matrix.m[3]) };
+    for(size_t i = 0; i < count; i++)
+    {
+        _mm_storeu_ps(&out[i].x, TransformRow(rows, in[i]));
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        out[i] = TransformHomogeneous(matrix, in[i]);
+    }
+#endif
+}
+
+void MathLib::TransformHomogeneous(const Mat4 &matrix, const Point3f *in, Point4f *out, unsigned char *clipFlags, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_HOMOGENEOUS_TRANSFORM_BATCH, count);
+#ifdef MATHLIB_SSE
+    const __m128 rows[4] = { _mm_loadu_ps(matrix.m[0]), _mm_loadu_ps(matrix.m[1]), _mm_loadu_ps(matrix.m[2]), _mm_loadu_ps(matrix.m[3]) };
+    for(size_t i = 0; i < count; i++)
+    {
+        __m128 v = TransformRow(rows, in[i]);
+        _mm_storeu_ps(&out[i].x, v);
+        clipFlags[i] = GetClipFlags(v);
+    }
+#else
+    for(size_t i = 0; i < count; i++)
+    {
+        out[i] = TransformHomogeneous(matrix, in[i]);
+        clipFlags[i] = GetClipFlags(out[i]);
+    }
+#endif
+}
+
+void MathLib::ComputeClipFlags(const Point4f *in, unsigned char *clipFlags, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_CLIP_FLAGS_BATCH, count);
+    for(size_t i = 0; i < count; i++)
+    {
+#ifdef MATHLIB_SSE
+        clipFlags[i] = GetClipFlags(_mm_loadu_ps(&in[i].x));
+#else
+        clipFlags[i] = GetClipFlags(in[i]);
+#endif
+    }
+}
+
+void MathLib::PerspectiveDivide(const Point4f *in, Point3f *out, size_t count)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_PERSPECTIVE_DIVIDE_BATCH, count);
+    size_t i = 0;
+#ifdef MATHLIB_SSE
+    static_assert(sizeof(Point3f) == 3 * sizeof(float), "Point3f arrays are written as float arrays");
+    const __m128 one = _mm_set1_ps(1.0f);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128 p0 = _mm_loadu_ps(&in[i].x);
+        __m128 p1 = _mm_loadu_ps(&in[i + 1].x);
+        __m128 p2 = _mm_loadu_ps(&in[i + 2].x);
+        __m128 p3 = _mm_loadu_ps(&in[i + 3].x);
+
+        // one division gives the reciprocals of all four w, the products are those of the scalar code
+        __m128 w = _mm_shuffle_ps(_mm_unpackhi_ps(p0, p1), _mm_unpackhi_ps(p2, p3), _MM_SHUFFLE(3, 2, 3, 2));
+        __m128 inv = _mm_div_ps(one, w);
+        p0 = _mm_mul_ps(p0, _mm_shuffle_ps(inv, inv, _MM_SHUFFLE(0, 0, 0, 0)));
+        p1 = _mm_mul_ps(p1, _mm_shuffle_ps(inv, inv, _MM_SHUFFLE(1, 1, 1, 1)));
+        p2 = _mm_mul_ps(p2, _mm_shuffle_ps(inv, inv, _MM_SHUFFLE(2, 2, 2, 2)));
+        p3 = _mm_mul_ps(p3, _mm_shuffle_ps(inv, inv, _MM_SHUFFLE(3, 3, 3, 3)));
+
+        // pack x, y and z of the four points into three vectors
+        float *result = &out[i].x;
+        __m128 z0x1 = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(0, 0, 2, 2));
+        __m128 z2x3 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(0, 0, 2, 2));
+        _mm_storeu_ps(result, _mm_shuffle_ps(p0, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+        _mm_storeu_ps(result + 4, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 0, 2, 1)));
+        _mm_storeu_ps(result + 8, _mm_shuffle_ps(z2x3, p3, _MM_SHUFFLE(2, 1, 2, 0)));
+    }
+#endif
+    for(; i < count; i++)
+    {
+        float inv = 1.0f / in[i].w;
+        out[i].x = in[i].x * inv;
+        out[i].y = in[i].y * inv;
+        out[i].z = in[i].z * inv;
+    }
+}
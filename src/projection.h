@@ -0,0 +1,49 @@
+#ifndef MATH_PROJECTION_H
+#define MATH_PROJECTION_H
+
+#include <cstddef>
+#include "vec.h"
+#include "matrix.h"
+
+/*! \file projection.h
+  \brief Contains batched homogeneous transforms, perspective divide and clip flag generation
+  */
+
+namespace MathLib
+{
+    /*! Clip plane flags, a vertex is inside the view volume when no flag is set.
+      Clip space follows MatrixPerspective and MatrixOrtho: -w <= x <= w, -w <= y <= w, 0 <= z <= w.
+      With a reversed-Z projection CLIP_NEAR and CLIP_FAR swap their meaning.
+      */
+    enum ClipFlags
+    {
+        CLIP_LEFT = 1,
+        CLIP_RIGHT = 2,
+        CLIP_BOTTOM = 4,
+        CLIP_TOP = 8,
+        CLIP_NEAR = 16,
+        CLIP_FAR = 32
+    };
+
+    /*! Transforms a point (x, y, z, 1) by a 4x4 matrix as a row vector, keeping w */
+    Point4f TransformHomogeneous(const Mat4 &matrix, const Point3f &point);
+
+    /*! Transforms an array of points to clip space
+      \param matrix Usually projection * view, Mat4::operator * applies the right operand first
+      \param in Input points, w is assumed to be 1
+      \param out Output clip space coordinates
+      \param count Number of points
+      */
+    void TransformHomogeneous(const Mat4 &matrix, const Point3f *in, Point4f *out, size_t count);
+
+    /*! Transforms an array of points to clip space and computes their clip flags in the same pass */
+    void TransformHomogeneous(const Mat4 &matrix, const Point3f *in, Point4f *out, unsigned char *clipFlags, size_t count);
+
+    /*! Computes ClipFlags for an array of clip space coordinates */
+    void ComputeClipFlags(const Point4f *in, unsigned char *clipFlags, size_t count);
+
+    /*! Divides x, y and z by w, giving normalized device coordinates. Points with w equal to 0 give infinities */
+    void PerspectiveDivide(const Point4f *in, Point3f *out, size_t count);
+}
+
+#endif
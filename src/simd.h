@@ -0,0 +1,26 @@
+#ifndef MATH_SIMD_H
+#define MATH_SIMD_H
+
+/*! \file simd.h
+  \brief Detects SIMD instruction sets available to the compiler.
+  Defines MATHLIB_X86 on x86 and x86-64 targets, whatever the SIMD settings, and MATHLIB_SSE when the SSE2
+  paths can be used, define MATHLIB_NO_SIMD to force the scalar code.
+  SSE code exists for VecOps<4, float> (Vec4f arithmetic and Dot), Mat4::operator *, TransformHomogeneous,
+  ComputeClipFlags, PerspectiveDivide, the Color4f, Color3f and ColorPlanes batch operations in color.h
+  CompressedTrack::Decompress and the row eliminations of DecomposeLU and Solve3x3. Everything else,
+  including Vec3, Affine3x4, Mat2, Mat3, the curves and the other decompositions, is scalar code left
+  to the compiler. There are no AVX paths.
+  */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MATHLIB_X86
+#endif
+
+#if !defined(MATHLIB_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATHLIB_SSE
+#include <emmintrin.h>
+#endif
+#endif
+
+#endif
@@ -0,0 +1,672 @@
+#include <cmath>
+#include <stdexcept>
+#include "track.h"
+#include "decompose.h"
+#include "simd.h"
+#include "profiler.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const float QUATERNION_RANGE = 0.70710678f;
+
+    class BitWriter
+    {
+        public:
+            BitWriter(vector<uint64_t> &words) : words(words), position(0)
+            {
+            }
+
+            void Write(uint64_t value, int count)
+            {
+                if(count == 0)
+                {
+                    return;
+                }
+                if(count < 64)
+                {
+                    value &= (uint64_t(1) << count) - 1;
+                }
+                size_t word = position >> 6;
+                int offset = static_cast<int>(position & 63);
+                if(words.size() < ((position + count + 63) >> 6))
+                {
+                    words.resize((position + count + 63) >> 6, 0);
+                }
+                words[word] |= value << offset;
+                if(offset + count > 64)
+                {
+                    words[word + 1] |= value >> (64 - offset);
+                }
+                position += count;
+            }
+
+            size_t GetPosition() const
+            {
+                return position;
+            }
+
+        private:
+            vector<uint64_t> &words;
+            size_t position;
+    };
+
+    class BitReader
+    {
+        public:
+            BitReader(const vector<uint64_t> &words, size_t position) : words(words), position(position)
+            {
+            }
+
+            uint64_t Read(int count)
+            {
+                if(count == 0)
+                {
+                    return 0;
+                }
+                // the stream ends with a padding word, so the next word can always be read;
+                // shifting in two steps keeps the shift below 64 when offset is 0
+                size_t word = position >> 6;
+                int offset = static_cast<int>(position & 63);
+                uint64_t value = (words[word] >> offset) | ((words[word + 1] << 1) << (63 - offset));
+                if(count < 64)
+                {
+                    value &= (uint64_t(1) << count) - 1;
+                }
+                position += count;
+                return value;
+            }
+
+        private:
+            const vector<uint64_t> &words;
+            size_t position;
+    };
+
+    struct QuantizedVec3
+    {
+        int32_t v[3];
+    };
+
+    //! Base value and delta bit widths of one block of quantized vectors
+    struct BlockHeader
+    {
+        QuantizedVec3 base;
+        int width[3];
+
+        void Compute(const QuantizedVec3 *values, size_t count)
+        {
+            base = values[0];
+            for(int c = 0; c < 3; c++)
+            {
+                uint64_t maximum = 0;
+                for(size_t i = 1; i < count; i++)
+                {
+                    uint64_t delta = ZigZag(static_cast<int64_t>(values[i].v[c]) - values[i - 1].v[c]);
+                    if(delta > maximum)
+                    {
+                        maximum = delta;
+                    }
+                }
+                width[c] = 0;
+                while(maximum > 0)
+                {
+                    width[c]++;
+                    maximum >>= 1;
+                }
+            }
+        }
+
+        void Write(BitWriter &writer) const
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                writer.Write(static_cast<uint32_t>(base.v[c]), 32);
+                writer.Write(width[c], 6);
+            }
+        }
+
+        void Read(BitReader &reader)
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                base.v[c] = static_cast<int32_t>(static_cast<uint32_t>(reader.Read(32)));
+                width[c] = static_cast<int>(reader.Read(6));
+            }
+        }
+
+        void WriteDelta(BitWriter &writer, const QuantizedVec3 &previous, const QuantizedVec3 &current) const
+        {
+            for(int c = 0; c < 3; c++)
+            {
+                writer.Write(ZigZag(static_cast<int64_t>(current.v[c]) - previous.v[c]), width[c]);
+            }
+        }
+
+        void ReadDelta(BitReader &reader, QuantizedVec3 &value) const
+        {
+            // widths are at most 33 bits, the three fields usually fit into a single read
+            int total = width[0] + width[1] + width[2];
+            if(total > 64)
+            {
+                for(int c = 0; c < 3; c++)
+                {
+                    value.v[c] = static_cast<int32_t>(value.v[c] + UnZigZag(reader.Read(width[c])));
+                }
+                return;
+            }
+            uint64_t bits = reader.Read(total);
+            for(int c = 0; c < 3; c++)
+            {
+                value.v[c] = static_cast<int32_t>(value.v[c] + UnZigZag(bits & ((uint64_t(1) << width[c]) - 1)));
+                bits >>= width[c];
+            }
+        }
+
+        static uint64_t ZigZag(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        static int64_t UnZigZag(uint64_t value)
+        {
+            return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+        }
+    };
+
+    float StepFromTolerance(float tolerance)
+    {
+        if(!(tolerance > 0.0f))
+        {
+            throw std::invalid_argument("tolerance must be greater than zero.");
+        }
+        // Vec3::Equals compares squared distance; half of the per-axis budget goes to
+        // quantization (step / 2), the other half is left for float rounding of the result
+        return sqrtf(tolerance / 3.0f);
+    }
+
+    QuantizedVec3 Quantize(float x, float y, float z, float step)
+    {
+        const float values[3] = { x, y, z };
+        QuantizedVec3 result;
+        for(int c = 0; c < 3; c++)
+        {
+            double scaled = floor(static_cast<double>(values[c]) / step + 0.5);
+            if(!(fabs(scaled) < 2147483647.0))
+            {
+                throw std::range_error("Value is out of range for the requested tolerance.");
+            }
+            result.v[c] = static_cast<int32_t>(scaled);
+        }
+        return result;
+    }
+
+    Vec3f Dequantize(const QuantizedVec3 &value, float step)
+    {
+        double scale = step;
+        return Vec3f(static_cast<float>(value.v[0] * scale), static_cast<float>(value.v[1] * scale), static_cast<float>(value.v[2] * scale));
+    }
+
+    void WriteQuaternion(BitWriter &writer, float q[4])
+    {
+        int largest = 0;
+        for(int i = 1; i < 4; i++)
+        {
+            if(fabsf(q[i]) > fabsf(q[largest]))
+            {
+                largest = i;
+            }
+        }
+        float sign = q[largest] < 0.0f ? -1.0f : 1.0f;
+        const float scale = ((1 << TRACK_ROTATION_BITS) - 1) / (2.0f * QUATERNION_RANGE);
+
+        writer.Write(largest, 2);
+        for(int i = 0; i < 4; i++)
+        {
+            if(i == largest)
+            {
+                continue;
+            }
+            float value = (sign * q[i] + QUATERNION_RANGE) * scale + 0.5f;
+            if(value < 0.0f)
+            {
+                value = 0.0f;
+            }
+            if(value > (1 << TRACK_ROTATION_BITS) - 1)
+            {
+                value = static_cast<float>((1 << TRACK_ROTATION_BITS) - 1);
+            }
+            writer.Write(static_cast<uint64_t>(value), TRACK_ROTATION_BITS);
+        }
+    }
+
+    //! Quantized components of the frames of one block, stored per component for SIMD decoding
+    struct FrameBlock
+    {
+        int32_t rotation[4][TRACK_BLOCK_SIZE];	// the largest component is stored as 0
+        int32_t translation[3][TRACK_BLOCK_SIZE];
+        int32_t scale[3][TRACK_BLOCK_SIZE];
+        int32_t largest[TRACK_BLOCK_SIZE];
+    };
+
+    // Reads the largest component index and the three stored quaternion components with a single read
+    void ReadQuaternion(BitReader &reader, FrameBlock &block, size_t frame)
+    {
+        const uint64_t fieldMask = (uint64_t(1) << TRACK_ROTATION_BITS) - 1;
+        uint64_t bits = reader.Read(2 + 3 * TRACK_ROTATION_BITS);
+        int largest = static_cast<int>(bits & 3);
+        bits >>= 2;
+
+        // insert an empty field at the largest component with shifts, branching on the index mispredicts
+        int split = largest * TRACK_ROTATION_BITS;
+        uint64_t below = bits & ((uint64_t(1) << split) - 1);
+        uint64_t above = ((bits >> split) << split) << TRACK_ROTATION_BITS;
+        bits = below | above;
+        for(int i = 0; i < 4; i++)
+        {
+            block.rotation[i][frame] = static_cast<int32_t>((bits >> (i * TRACK_ROTATION_BITS)) & fieldMask);
+        }
+        block.largest[frame] = largest;
+    }
+
+    void SetQuantized(int32_t values[3][TRACK_BLOCK_SIZE], size_t frame, const QuantizedVec3 &value)
+    {
+        values[0][frame] = value.v[0];
+        values[1][frame] = value.v[1];
+        values[2][frame] = value.v[2];
+    }
+
+    // Dequantizes the quaternion of a block frame and reconstructs the largest component from the unit length
+    void DecodeRotation(const FrameBlock &block, size_t i, float q[4])
+    {
+        const float scale = (2.0f * QUATERNION_RANGE) / ((1 << TRACK_ROTATION_BITS) - 1);
+        // the stored components are kept in registers and the largest one is selected arithmetically,
+        // branching on its index mispredicts
+        int largest = block.largest[i];
+        float x = (block.rotation[0][i] * scale - QUATERNION_RANGE) * static_cast<float>(largest != 0);
+        float y = (block.rotation[1][i] * scale - QUATERNION_RANGE) * static_cast<float>(largest != 1);
+        float z = (block.rotation[2][i] * scale - QUATERNION_RANGE) * static_cast<float>(largest != 2);
+        float w = (block.rotation[3][i] * scale - QUATERNION_RANGE) * static_cast<float>(largest != 3);
+        float sum = x * x + y * y + z * z + w * w;
+        float missing = sum < 1.0f ? sqrtf(1.0f - sum) : 0.0f;
+
+        q[0] = x + missing * static_cast<float>(largest == 0);
+        q[1] = y + missing * static_cast<float>(largest == 1);
+        q[2] = z + missing * static_cast<float>(largest == 2);
+        q[3] = w + missing * static_cast<float>(largest == 3);
+    }
+
+    Vec3f DequantizeFrame(const int32_t values[3][TRACK_BLOCK_SIZE], size_t i, float step)
+    {
+        QuantizedVec3 value = { { values[0][i], values[1][i], values[2][i] } };
+        return Dequantize(value, step);
+    }
+
+    void SplitTransform(const Mat4 &matrix, Vec3f &translation, float rotation[4], Vec3f &scale)
+    {
+        if(matrix.data._14 != 0.0f || matrix.data._24 != 0.0f || matrix.data._34 != 0.0f || matrix.data._44 != 1.0f)
+        {
+            throw std::invalid_argument("Track frames must be affine matrices.");
+        }
+
+        Mat4 rotationMatrix;
+        if(!DecomposeTransform(matrix, translation, rotationMatrix, scale))
+        {
+            throw std::invalid_argument("Track frames must have non-zero scale.");
+        }
+        const float (*r)[4] = rotationMatrix.m;
+
+        float trace = r[0][0] + r[1][1] + r[2][2];
+        float &x = rotation[0], &y = rotation[1], &z = rotation[2], &w = rotation[3];
+        if(trace > 0.0f)
+        {
+            float t = sqrtf(trace + 1.0f) * 2.0f;
+            w = 0.25f * t;
+            x = (r[2][1] - r[1][2]) / t;
+            y = (r[0][2] - r[2][0]) / t;
+            z = (r[1][0] - r[0][1]) / t;
+        }
+        else if(r[0][0] > r[1][1] && r[0][0] > r[2][2])
+        {
+            float t = sqrtf(1.0f + r[0][0] - r[1][1] - r[2][2]) * 2.0f;
+            w = (r[2][1] - r[1][2]) / t;
+            x = 0.25f * t;
+            y = (r[0][1] + r[1][0]) / t;
+            z = (r[0][2] + r[2][0]) / t;
+        }
+        else if(r[1][1] > r[2][2])
+        {
+            float t = sqrtf(1.0f + r[1][1] - r[0][0] - r[2][2]) * 2.0f;
+            w = (r[0][2] - r[2][0]) / t;
+            x = (r[0][1] + r[1][0]) / t;
+            y = 0.25f * t;
+            z = (r[1][2] + r[2][1]) / t;
+        }
+        else
+        {
+            float t = sqrtf(1.0f + r[2][2] - r[0][0] - r[1][1]) * 2.0f;
+            w = (r[1][0] - r[0][1]) / t;
+            x = (r[0][2] + r[2][0]) / t;
+            y = (r[1][2] + r[2][1]) / t;
+            z = 0.25f * t;
+        }
+    }
+
+    void ComposeTransform(Mat4 &matrix, const Vec3f &translation, const float rotation[4], const Vec3f &scale)
+    {
+        float x = rotation[0], y = rotation[1], z = rotation[2], w = rotation[3];
+
+        matrix.data._11 = scale.x * (1.0f - 2.0f * (y * y + z * z));
+        matrix.data._12 = scale.x * (2.0f * (x * y - w * z));
+        matrix.data._13 = scale.x * (2.0f * (x * z + w * y));
+        matrix.data._14 = 0.0f;
+
+        matrix.data._21 = scale.y * (2.0f * (x * y + w * z));
+        matrix.data._22 = scale.y * (1.0f - 2.0f * (x * x + z * z));
+        matrix.data._23 = scale.y * (2.0f * (y * z - w * x));
+        matrix.data._24 = 0.0f;
+
+        matrix.data._31 = scale.z * (2.0f * (x * z - w * y));
+        matrix.data._32 = scale.z * (2.0f * (y * z + w * x));
+        matrix.data._33 = scale.z * (1.0f - 2.0f * (x * x + y * y));
+        matrix.data._34 = 0.0f;
+
+        matrix.data._41 = translation.x;
+        matrix.data._42 = translation.y;
+        matrix.data._43 = translation.z;
+        matrix.data._44 = 1.0f;
+    }
+
+#ifdef MATHLIB_SSE
+    // Dequantizes four values the way Dequantize does
+    inline __m128 DequantizeLanes(const int32_t *values, __m128d step)
+    {
+        __m128i integers = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+        __m128 low = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(integers), step));
+        __m128 high = _mm_cvtpd_ps(_mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(integers, _MM_SHUFFLE(1, 0, 3, 2))), step));
+        return _mm_movelh_ps(low, high);
+    }
+
+    // Writes the rows of four matrices given the row entries of all four as lanes
+    inline void StoreRows(Mat4 *frames, int row, __m128 a, __m128 b, __m128 c, __m128 d)
+    {
+        _MM_TRANSPOSE4_PS(a, b, c, d);
+        _mm_storeu_ps(frames[0].m[row], a);
+        _mm_storeu_ps(frames[1].m[row], b);
+        _mm_storeu_ps(frames[2].m[row], c);
+        _mm_storeu_ps(frames[3].m[row], d);
+    }
+#endif
+
+    /* Builds the matrices of block frames [first, last). The SSE path decodes four frames at a time
+       with the operations of DecodeRotation, Dequantize and ComposeTransform, so results are equal */
+    void DecodeFrames(Mat4 *frames, const FrameBlock &block, size_t first, size_t last, float step)
+    {
+        size_t i = first;
+#ifdef MATHLIB_SSE
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 two = _mm_set1_ps(2.0f);
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 rotationScale = _mm_set1_ps((2.0f * QUATERNION_RANGE) / ((1 << TRACK_ROTATION_BITS) - 1));
+        const __m128d steps = _mm_set1_pd(step);
+        for(; i + 4 <= last; i += 4, frames += 4)
+        {
+            __m128i largest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&block.largest[i]));
+            __m128 q[4];
+            __m128 isLargest[4];
+            __m128 sum = zero;
+            for(int c = 0; c < 4; c++)
+            {
+                __m128 values = _mm_cvtepi32_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&block.rotation[c][i])));
+                isLargest[c] = _mm_castsi128_ps(_mm_cmpeq_epi32(largest, _mm_set1_epi32(c)));
+                q[c] = _mm_andnot_ps(isLargest[c], _mm_sub_ps(_mm_mul_ps(values, rotationScale), _mm_set1_ps(QUATERNION_RANGE)));
+                sum = _mm_add_ps(sum, _mm_mul_ps(q[c], q[c]));
+            }
+            __m128 missing = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(one, sum), zero));
+            for(int c = 0; c < 4; c++)
+            {
+                q[c] = _mm_or_ps(q[c], _mm_and_ps(isLargest[c], missing));
+            }
+
+            __m128 x = q[0], y = q[1], z = q[2], w = q[3];
+            __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+            __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+            __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+            __m128 sx = DequantizeLanes(&block.scale[0][i], steps);
+            __m128 sy = DequantizeLanes(&block.scale[1][i], steps);
+            __m128 sz = DequantizeLanes(&block.scale[2][i], steps);
+
+            StoreRows(frames, 0,
+                    _mm_mul_ps(sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)))),
+                    _mm_mul_ps(sx, _mm_mul_ps(two, _mm_sub_ps(xy, wz))),
+                    _mm_mul_ps(sx, _mm_mul_ps(two, _mm_add_ps(xz, wy))),
+                    zero);
+            StoreRows(frames, 1,
+                    _mm_mul_ps(sy, _mm_mul_ps(two, _mm_add_ps(xy, wz))),
+                    _mm_mul_ps(sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)))),
+                    _mm_mul_ps(sy, _mm_mul_ps(two, _mm_sub_ps(yz, wx))),
+                    zero);
+            StoreRows(frames, 2,
+                    _mm_mul_ps(sz, _mm_mul_ps(two, _mm_sub_ps(xz, wy))),
+                    _mm_mul_ps(sz, _mm_mul_ps(two, _mm_add_ps(yz, wx))),
+                    _mm_mul_ps(sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)))),
+                    zero);
+            StoreRows(frames, 3,
+                    DequantizeLanes(&block.translation[0][i], steps),
+                    DequantizeLanes(&block.translation[1][i], steps),
+                    DequantizeLanes(&block.translation[2][i], steps),
+                    one);
+        }
+#endif
+        for(; i < last; i++, frames++)
+        {
+            float rotation[4];
+            DecodeRotation(block, i, rotation);
+            ComposeTransform(*frames, DequantizeFrame(block.translation, i, step), rotation, DequantizeFrame(block.scale, i, step));
+        }
+    }
+}
+
+CompressedTrack::CompressedTrack() : frameCount(0), step(0.0f)
+{
+}
+
+CompressedTrack::CompressedTrack(const Mat4 *frames, size_t count, float tolerance) : frameCount(0), step(0.0f)
+{
+    Compress(frames, count, tolerance);
+}
+
+void CompressedTrack::Compress(const Mat4 *frames, size_t count, float tolerance)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_TRACK_COMPRESS, count);
+    float newStep = StepFromTolerance(tolerance);
+
+    vector<QuantizedVec3> translations(count);
+    vector<QuantizedVec3> scales(count);
+    vector<float> rotations(count * 4);
+    for(size_t i = 0; i < count; i++)
+    {
+        Vec3f translation, scale;
+        SplitTransform(frames[i], translation, &rotations[i * 4], scale);
+        translations[i] = Quantize(translation.x, translation.y, translation.z, newStep);
+        scales[i] = Quantize(scale.x, scale.y, scale.z, newStep);
+    }
+
+    stream.clear();
+    blockOffsets.clear();
+    BitWriter writer(stream);
+    for(size_t block = 0; block < count; block += TRACK_BLOCK_SIZE)
+    {
+        size_t blockSize = count - block < TRACK_BLOCK_SIZE ? count - block : TRACK_BLOCK_SIZE;
+        BlockHeader translationHeader, scaleHeader;
+        translationHeader.Compute(&translations[block], blockSize);
+        scaleHeader.Compute(&scales[block], blockSize);
+
+        blockOffsets.push_back(writer.GetPosition());
+        translationHeader.Write(writer);
+        scaleHeader.Write(writer);
+        for(size_t i = block; i < block + blockSize; i++)
+        {
+            WriteQuaternion(writer, &rotations[i * 4]);
+            if(i > block)
+            {
+                translationHeader.WriteDelta(writer, translations[i - 1], translations[i]);
+                scaleHeader.WriteDelta(writer, scales[i - 1], scales[i]);
+            }
+        }
+    }
+    stream.push_back(0);
+    frameCount = count;
+    step = newStep;
+}
+
+void CompressedTrack::Decompress(size_t first, size_t count, Mat4 *frames) const
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_TRACK_DECOMPRESS, count);
+    if(first > frameCount || count > frameCount - first)
+    {
+        throw std::range_error("Frame range is out of the track.");
+    }
+
+    size_t index = first - first % TRACK_BLOCK_SIZE;
+    size_t last = first + count;
+    while(index < last)
+    {
+        BitReader reader(stream, blockOffsets[index / TRACK_BLOCK_SIZE]);
+        BlockHeader translationHeader, scaleHeader;
+        translationHeader.Read(reader);
+        scaleHeader.Read(reader);
+        QuantizedVec3 translation = translationHeader.base;
+        QuantizedVec3 scale = scaleHeader.base;
+
+        size_t blockEnd = index + TRACK_BLOCK_SIZE < last ? index + TRACK_BLOCK_SIZE : last;
+        FrameBlock block;
+        for(size_t i = index; i < blockEnd; i++)
+        {
+            size_t frame = i - index;
+            ReadQuaternion(reader, block, frame);
+            if(frame != 0)
+            {
+                translationHeader.ReadDelta(reader, translation);
+                scaleHeader.ReadDelta(reader, scale);
+            }
+            SetQuantized(block.translation, frame, translation);
+            SetQuantized(block.scale, frame, scale);
+        }
+
+        // bit unpacking above is sequential, DecodeFrames processes four frames at a time
+        size_t start = index > first ? index : first;
+        DecodeFrames(frames + (start - first), block, start - index, blockEnd - index, step);
+        index = blockEnd;
+    }
+}
+
+Mat4 CompressedTrack::GetFrame(size_t index) const
+{
+    Mat4 result;
+    Decompress(index, 1, &result);
+    return result;
+}
+
+size_t CompressedTrack::GetFrameCount() const
+{
+    return frameCount;
+}
+
+size_t CompressedTrack::GetSizeInBytes() const
+{
+    return stream.size() * sizeof(uint64_t) + blockOffsets.size() * sizeof(size_t);
+}
+
+CompressedPointList::CompressedPointList() : pointCount(0), step(0.0f)
+{
+}
+
+void CompressedPointList::Compress(const Point3f *points, size_t count, float tolerance)
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_TRACK_COMPRESS, count);
+    float newStep = StepFromTolerance(tolerance);
+
+    vector<QuantizedVec3> values(count);
+    for(size_t i = 0; i < count; i++)
+    {
+        values[i] = Quantize(points[i].x, points[i].y, points[i].z, newStep);
+    }
+
+    stream.clear();
+    blockOffsets.clear();
+    BitWriter writer(stream);
+    for(size_t block = 0; block < count; block += TRACK_BLOCK_SIZE)
+    {
+        size_t blockSize = count - block < TRACK_BLOCK_SIZE ? count - block : TRACK_BLOCK_SIZE;
+        BlockHeader header;
+        header.Compute(&values[block], blockSize);
+
+        blockOffsets.push_back(writer.GetPosition());
+        header.Write(writer);
+        for(size_t i = block + 1; i < block + blockSize; i++)
+        {
+            header.WriteDelta(writer, values[i - 1], values[i]);
+        }
+    }
+    stream.push_back(0);
+    pointCount = count;
+    step = newStep;
+}
+
+void CompressedPointList::Compress(const list<Point3f> &points, float tolerance)
+{
+    vector<Point3f> values(points.begin(), points.end());
+    Compress(values.empty() ? 0 : &values[0], values.size(), tolerance);
+}
+
+void CompressedPointList::Decompress(size_t first, size_t count, Point3f *points) const
+{
+    MATHLIB_PROFILE_BATCH(PROFILE_TRACK_DECOMPRESS, count);
+    if(first > pointCount || count > pointCount - first)
+    {
+        throw std::range_error("Point range is out of the list.");
+    }
+
+    size_t index = first - first % TRACK_BLOCK_SIZE;
+    size_t last = first + count;
+    while(index < last)
+    {
+        BitReader reader(stream, blockOffsets[index / TRACK_BLOCK_SIZE]);
+        BlockHeader header;
+        header.Read(reader);
+        QuantizedVec3 value = header.base;
+
+        size_t blockEnd = index + TRACK_BLOCK_SIZE < last ? index + TRACK_BLOCK_SIZE : last;
+        for(size_t i = index; i < blockEnd; i++)
+        {
+            if(i % TRACK_BLOCK_SIZE != 0)
+            {
+                header.ReadDelta(reader, value);
+            }
+            if(i >= first)
+            {
+                points[i - first] = Dequantize(value, step);
+            }
+        }
+        index = blockEnd;
+    }
+}
+
+void CompressedPointList::Decompress(list<Point3f> &points) const
+{
+    vector<Point3f> values(pointCount);
+    Decompress(0, pointCount, values.empty() ? 0 : &values[0]);
+    points.assign(values.begin(), values.end());
+}
+
+size_t CompressedPointList::GetPointCount() const
+{
+    return pointCount;
+}
+
+size_t CompressedPointList::GetSizeInBytes() const
+{
+    return stream.size() * sizeof(uint64_t) + blockOffsets.size() * sizeof(size_t);
+}
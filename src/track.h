@@ -0,0 +1,121 @@
+#ifndef MATH_TRACK_H
+#define MATH_TRACK_H
+
+#include <vector>
+#include <list>
+#include <cstddef>
+#include <stdint.h>
+#include "vec.h"
+#include "matrix.h"
+
+/*! \file track.h
+  \brief Contains compressed storage for animation tracks and control point lists
+  */
+
+namespace MathLib
+{
+    /*! Number of frames sharing one absolute base value; decoding may start at any block */
+    const size_t TRACK_BLOCK_SIZE = 16;
+
+    /*! Number of bits used for each of the three stored quaternion components */
+    const int TRACK_ROTATION_BITS = 16;
+
+    //! Compressed track of affine transforms
+    /*!
+      Every frame is split into translation, rotation and scale.
+      Rotations are stored as smallest-three quaternions, translations and scales
+      are quantized, delta encoded and bit packed in blocks of TRACK_BLOCK_SIZE frames.
+      The quantization step is chosen so that decoded translations and scales satisfy
+      Vec3::Equals with the tolerance passed to Compress, as long as the float spacing of
+      the stored values does not exceed the quantization step.
+
+      Limits of the encoding:
+      - Rotations do not depend on the tolerance. With TRACK_ROTATION_BITS = 16 the decoded row
+        directions differ from the original ones by up to about 6e-5, so the upper 3x3 entries
+        differ by up to about 6e-5 times the scale of their row. This is above the 1e-5 default
+        tolerance of Vec3::Equals when applied to a row.
+      - Shear is lost. The row lengths are kept as the scale, but the row directions are replaced
+        by a rotation, so rows of a sheared matrix decode as mutually orthogonal.
+
+      Decompress unpacks the bits of a block sequentially. With MATHLIB_SSE it then dequantizes,
+      completes the quaternions and builds the matrices four frames at a time. Results are
+      equal to the scalar path.
+      */
+    class CompressedTrack
+    {
+        public:
+            /*! Creates an empty track */
+            CompressedTrack();
+
+            /*! Creates a track from an array of affine matrices */
+            CompressedTrack(const Mat4 *frames, size_t count, float tolerance = 0.00001f);
+
+            /*! Compresses an array of affine matrices, replacing the current content
+              \param frames Matrices to compress, _14, _24 and _34 must be 0 and _44 must be 1
+              \param count Number of matrices
+              \param tolerance Tolerance in the sense of Vec3::Equals for translations and scales
+              */
+            void Compress(const Mat4 *frames, size_t count, float tolerance = 0.00001f);
+
+            /*! Decodes a range of frames into a matrix array
+              \param first Index of the first frame to decode
+              \param count Number of frames to decode
+              \param frames Output array with room for count matrices
+              */
+            void Decompress(size_t first, size_t count, Mat4 *frames) const;
+
+            /*! Decodes a single frame */
+            Mat4 GetFrame(size_t index) const;
+
+            /*! Returns number of frames in the track */
+            size_t GetFrameCount() const;
+
+            /*! Returns memory used by the compressed data */
+            size_t GetSizeInBytes() const;
+
+        private:
+            std::vector<uint64_t> stream;
+            std::vector<size_t> blockOffsets;
+            size_t frameCount;
+            float step;
+    };
+
+    //! Compressed list of control points
+    /*!
+      Points are quantized, delta encoded and bit packed in blocks of TRACK_BLOCK_SIZE points.
+      Every decoded point satisfies Vec3::Equals with the tolerance passed to Compress,
+      as long as the float spacing of the coordinates does not exceed the quantization step.
+      */
+    class CompressedPointList
+    {
+        public:
+            /*! Creates an empty list */
+            CompressedPointList();
+
+            /*! Compresses an array of points, replacing the current content */
+            void Compress(const Point3f *points, size_t count, float tolerance = 0.00001f);
+
+            /*! Compresses a list of points, replacing the current content */
+            void Compress(const std::list<Point3f> &points, float tolerance = 0.00001f);
+
+            /*! Decodes a range of points into an array */
+            void Decompress(size_t first, size_t count, Point3f *points) const;
+
+            /*! Decodes all points into a list, replacing its content */
+            void Decompress(std::list<Point3f> &points) const;
+
+            /*! Returns number of points */
+            size_t GetPointCount() const;
+
+            /*! Returns memory used by the compressed data */
+            size_t GetSizeInBytes() const;
+
+        private:
+            std::vector<uint64_t> stream;
+            std::vector<size_t> blockOffsets;
+            size_t pointCount;
+            float step;
+    };
+}
+
+#endif
@@ -0,0 +1,19 @@
+#include "vec.h"
+#include "profiler.h"
+
+using namespace MathLib;
+
+template<typename T> Vec3<T>& MathLib::Vec3<T>::Transform(const Mat4 &matrix)
+{
+    MATHLIB_PROFILE_KERNEL(PROFILE_VEC3_TRANSFORM);
+    Vec3<T> result;
+    result.x = x * matrix.data._11 + y * matrix.data._12 + z * matrix.data._13 + matrix.data._41;
+    result.y = x * matrix.data._21 + y * matrix.data._22 + z * matrix.data._23 + matrix.data._42;
+    result.z = x * matrix.data._31 + y * matrix.data._32 + z * matrix.data._33 + matrix.data._43;
+    *this = result;
+    return *this;
+}
+
+template Vec3<float>& MathLib::Vec3<float>::Transform(const Mat4 &matrix);
+template Vec3<double>& MathLib::Vec3<double>::Transform(const Mat4 &matrix);
+template Vec3<int>& MathLib::Vec3<int>::Transform(const Mat4 &matrix);
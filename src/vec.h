@@ -4,6 +4,7 @@
 #include <cmath>
 #include <sstream>
 #include "matrix.h"
+#include "vecn.h"
 
 /*! \file vector.h
   \brief Contains 3D Vector declaration and definition.
@@ -11,16 +12,20 @@
 
 namespace MathLib
 {
+    template <typename T> class Vec<3, T>;
+    template <typename T> using Vec3 = Vec<3, T>;
+
     //! 3D Vector template class
     /*!
       Allows mathematical operations on a 3D vector.
       Includes several operators and basic functions such as dot or cross product.
+      Specialization of the Vec template, available as Vec3.
       */
-    template <typename T> class Vec3
+    template <typename T> class Vec<3, T>
     {
         public:
             /*! Default constructor. Sets all vector components to zeroes */
-            Vec3()
+            Vec()
             {
                 x = y = z = 0;
             }
@@ -30,7 +35,7 @@ namespace MathLib
               \param y Initial value of y component
               \param z Initial value of z component
               */
-            Vec3(T x, T y, T z)
+            Vec(T x, T y, T z)
             {
                 this->x = x;
                 this->y = y;
@@ -38,53 +43,65 @@ namespace MathLib
             }
 
             /*! Destructor. It does nothing special ;) */
-            ~Vec3()
+            ~Vec()
             {
             }
 
+            /*! Returns a component by index */
+            T& operator [](int i)
+            {
+                return (&x)[i];
+            }
+
+            /*! Returns a component by index */
+            const T& operator [](int i) const
+            {
+                return (&x)[i];
+            }
+
             // operators
 
             /*! Adds two vectors */
             Vec3<T> operator +(const Vec3<T>& v)
             {
-                return Vec3(x + v.x, y + v.y, z + v.z);
+                return Vec3<T>(x + v.x, y + v.y, z + v.z);
             }
 
             /*! Subtracts two vectors */
             Vec3<T> operator -(const Vec3<T>& v)
             {
-                return Vec3(x - v.x, y - v.y, z - v.z);
+                return Vec3<T>(x - v.x, y - v.y, z - v.z);
             }
 
 
             /*! Multiplies two vectors */
             Vec3<T> operator *(const Vec3<T>& v)
             {
-                return Vec3(x * v.x, y * v.y, z * v.z);
+                return Vec3<T>(x * v.x, y * v.y, z * v.z);
             }
 
             /*! Divides one vector by another */
             Vec3<T> operator /(const Vec3<T>& v)
             {
-                return Vec3(x / v.x, y / v.y, z / v.z);
+                return Vec3<T>(x / v.x, y / v.y, z / v.z);
             }
 
             /*! Adds scalar value to the vector */
             Vec3<T> operator +(const T& scalar)
             {
-                return Vec3(x + scalar, y + scalar, z + scalar);
+                return Vec3<T>(x + scalar, y + scalar, z + scalar);
             }
 
             /*! Subtracts scalar value from the vector */
             Vec3<T> operator -(const T& scalar)
             {
-                return Vec3(x - scalar, y - scalar, z - scalar);
+                return Vec3<T>(x - scalar, y - scalar, z - scalar);
             }
 
             /*! Multiplies the vector by a scalar value */
             Vec3<T> operator *(const T& scalar)
             {
-                return Vec3(x * scalar, y * scalar, z * scalar);
+                return Vec3<T>(x * scalar, y * scalar, z * scalar);
             }
 
             /*! Divides the vector by a scalar value */
@@ -195,7 +212,7 @@ namespace MathLib
             }
 
             /*! Writes string representation of the vector to the stream */
-            friend std::ostream & operator << (std::ostream &out, const Vec3 &v)
+            friend std::ostream & operator << (std::ostream &out, const Vec3<T> &v)
             {
                 out << v.x << ", " << v.y << ", " << v.z;
                 return out;
@@ -269,16 +286,10 @@ namespace MathLib
                 return (this->Dot(v) / (vLength * vLength)) * v;
             }
 
-            /*! Transforms the vector by a 4x4 matrix */
-            Vec3<T>& Transform(const Mat4 &matrix)
-            {
-                Vec3<T> result;
-                result.x = x * matrix.data._11 + y * matrix.data._12 + z * matrix.data._13 + matrix.data._41;
-                result.y = x * matrix.data._21 + y * matrix.data._22 + z * matrix.data._23 + matrix.data._42;
-                result.z = x * matrix.data._31 + y * matrix.data._32 + z * matrix.data._33 + matrix.data._43;
-                *this = result;
-                return *this;
-            }
+            /*! Transforms the vector by a 4x4 matrix. Defined in vec.cpp for Vec3f, Vec3d and Vec3i,
+              so the profiling hook is compiled with the library settings
+              */
+            Vec3<T>& Transform(const Mat4 &matrix);
 
 
             // vector components
@@ -293,17 +304,8 @@ namespace MathLib
     typedef Vec3f Vector;
     typedef Vec3f Point3f;
 
-    struct Point2f
-    {
-        public:
-            float x, y;
-            Point2f(){};
-            Point2f(float x, float y)
-            {
-                this->x = x;
-                this->y = y;
-            }
-    };
+    typedef Vec2f Point2f;
+    typedef Vec4f Point4f;
 
     struct Color3f
     {
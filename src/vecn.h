@@ -0,0 +1,307 @@
+#ifndef VECN_H
+#define VECN_H
+
+#include <cmath>
+#include <ostream>
+#include <type_traits>
+#include "simd.h"
+
+/*! \file vecn.h
+  \brief Contains N-dimensional Vector template declaration and definition.
+  Vec<3, T> is specialized in vec.h and keeps the original Vec3 interface.
+  */
+
+namespace MathLib
+{
+    //! Calls a function with every index from I to N - 1, unrolled at compile time
+    template<int I, int N> struct Unroll
+    {
+        template<class Function> static void Apply(Function function)
+        {
+            function(std::integral_constant<int, I>());
+            Unroll<I + 1, N>::Apply(function);
+        }
+    };
+
+    template<int N> struct Unroll<N, N>
+    {
+        template<class Function> static void Apply(Function)
+        {
+        }
+    };
+
+    //! Component storage, vectors up to 4 components get named members
+    template<int N, typename T> struct VecStorage
+    {
+        T v[N];
+
+        T* Components() { return v; }
+        const T* Components() const { return v; }
+    };
+
+    template<typename T> struct VecStorage<2, T>
+    {
+        T x; //!< x component of a vector
+        T y; //!< y component of a vector
+
+        T* Components() { return &x; }
+        const T* Components() const { return &x; }
+    };
+
+    template<typename T> struct VecStorage<4, T>
+    {
+        T x; //!< x component of a vector
+        T y; //!< y component of a vector
+        T z; //!< z component of a vector
+        T w; //!< w component of a vector
+
+        T* Components() { return &x; }
+        const T* Components() const { return &x; }
+    };
+
+    //! Element-wise kernels used by Vec, specialized for sizes with SIMD support
+    template<int N, typename T> struct VecOps
+    {
+        static void Add(T *r, const T *a, const T *b) { Unroll<0, N>::Apply([&](int i) { r[i] = a[i] + b[i]; }); }
+        static void Sub(T *r, const T *a, const T *b) { Unroll<0, N>::Apply([&](int i) { r[i] = a[i] - b[i]; }); }
+        static void Mul(T *r, const T *a, const T *b) { Unroll<0, N>::Apply([&](int i) { r[i] = a[i] * b[i]; }); }
+        static void Div(T *r, const T *a, const T *b) { Unroll<0, N>::Apply([&](int i) { r[i] = a[i] / b[i]; }); }
+        static void Scale(T *r, const T *a, T s) { Unroll<0, N>::Apply([&](int i) { r[i] = a[i] * s; }); }
+
+        static T Dot(const T *a, const T *b)
+        {
+            T result = 0;
+            Unroll<0, N>::Apply([&](int i) { result += a[i] * b[i]; });
+            return result;
+        }
+    };
+
+#ifdef MATHLIB_SSE
+    template<> struct VecOps<4, float>
+    {
+        static void Add(float *r, const float *a, const float *b) { _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+        static void Sub(float *r, const float *a, const float *b) { _mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+        static void Mul(float *r, const float *a, const float *b) { _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+        static void Div(float *r, const float *a, const float *b) { _mm_storeu_ps(r, _mm_div_ps(_mm_loadu_ps(a), _mm_loadu_ps(b))); }
+        static void Scale(float *r, const float *a, float s) { _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(s))); }
+
+        static float Dot(const float *a, const float *b)
+        {
+            __m128 p = _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b));
+            __m128 s = _mm_add_ps(p, _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 3, 0, 1)));
+            s = _mm_add_ss(s, _mm_movehl_ps(s, s));
+            return _mm_cvtss_f32(s);
+        }
+    };
+#endif
+
+    //! N-dimensional Vector template class
+    /*!
+      Allows mathematical operations on vectors of any fixed size.
+      Loops over components are unrolled at compile time, Vec<4, float>
+      uses SSE when it is available.
+      */
+    template<int N, typename T> class Vec : public VecStorage<N, T>
+    {
+        public:
+            /*! Default constructor. Sets all vector components to zeroes */
+            Vec()
+            {
+                T *c = this->Components();
+                Unroll<0, N>::Apply([&](int i) { c[i] = 0; });
+            }
+
+            /*! Sets all vector components to a scalar value */
+            explicit Vec(T scalar)
+            {
+                T *c = this->Components();
+                Unroll<0, N>::Apply([&](int i) { c[i] = scalar; });
+            }
+
+            /*! Inits all vector components, one value per component */
+            template<typename... Args, typename = typename std::enable_if<sizeof...(Args) == N && (N > 1)>::type>
+            Vec(Args... args)
+            {
+                const T values[N] = { static_cast<T>(args)... };
+                T *c = this->Components();
+                Unroll<0, N>::Apply([&](int i) { c[i] = values[i]; });
+            }
+
+            /*! Returns a component by index */
+            T& operator [](int i)
+            {
+                return this->Components()[i];
+            }
+
+            /*! Returns a component by index */
+            const T& operator [](int i) const
+            {
+                return this->Components()[i];
+            }
+
+            // operators
+
+            /*! Adds two vectors */
+            Vec operator +(const Vec &v) const
+            {
+                Vec result;
+                VecOps<N, T>::Add(result.Components(), this->Components(), v.Components());
+                return result;
+            }
+
+            /*! Subtracts two vectors */
+            Vec operator -(const Vec &v) const
+            {
+                Vec result;
+                VecOps<N, T>::Sub(result.Components(), this->Components(), v.Components());
+                return result;
+            }
+
+            /*! Multiplies two vectors */
+            Vec operator *(const Vec &v) const
+            {
+                Vec result;
+                VecOps<N, T>::Mul(result.Components(), this->Components(), v.Components());
+                return result;
+            }
+
+            /*! Divides one vector by another */
+            Vec operator /(const Vec &v) const
+            {
+                Vec result;
+                VecOps<N, T>::Div(result.Components(), this->Components(), v.Components());
+                return result;
+            }
+
+            /*! Multiplies the vector by a scalar value */
+            Vec operator *(const T &scalar) const
+            {
+                Vec result;
+                VecOps<N, T>::Scale(result.Components(), this->Components(), scalar);
+                return result;
+            }
+
+            /*! Divides the vector by a scalar value */
+            Vec operator /(const T &scalar) const
+            {
+                Vec result;
+                const T *c = this->Components();
+                T *r = result.Components();
+                Unroll<0, N>::Apply([&](int i) { r[i] = c[i] / scalar; });
+                return result;
+            }
+
+            /*! Negates the vectors components */
+            Vec operator -() const
+            {
+                Vec result;
+                VecOps<N, T>::Scale(result.Components(), this->Components(), T(-1));
+                return result;
+            }
+
+            /*! Adds a vector to the current one */
+            Vec& operator +=(const Vec &v)
+            {
+                VecOps<N, T>::Add(this->Components(), this->Components(), v.Components());
+                return *this;
+            }
+
+            /*! Subtracts a vector from the current one */
+            Vec& operator -=(const Vec &v)
+            {
+                VecOps<N, T>::Sub(this->Components(), this->Components(), v.Components());
+                return *this;
+            }
+
+            /*! Multiplies the current vector by another one */
+            Vec& operator *=(const Vec &v)
+            {
+                VecOps<N, T>::Mul(this->Components(), this->Components(), v.Components());
+                return *this;
+            }
+
+            /*! Multiplies the current vector by a scalar value */
+            Vec& operator *=(const T &scalar)
+            {
+                VecOps<N, T>::Scale(this->Components(), this->Components(), scalar);
+                return *this;
+            }
+
+            /*! Divides the current vector by a scalar value */
+            Vec& operator /=(const T &scalar)
+            {
+                *this = *this / scalar;
+                return *this;
+            }
+
+            /*! Returns true if two vectors are equal */
+            bool operator ==(const Vec &v) const
+            {
+                bool equal = true;
+                const T *c = this->Components();
+                Unroll<0, N>::Apply([&](int i) { equal = equal && c[i] == v[i]; });
+                return equal;
+            }
+
+            /*! Returns true if two vectors are not equal */
+            bool operator !=(const Vec &v) const
+            {
+                return !(*this == v);
+            }
+
+            /*! Multiplies a scalar value by the vector when a scalar is on the left side */
+            friend Vec operator *(const T &scalar, const Vec &v)
+            {
+                return v * scalar;
+            }
+
+            /*! Writes string representation of the vector to the stream */
+            friend std::ostream & operator << (std::ostream &out, const Vec &v)
+            {
+                for(int i = 0; i < N; i++)
+                {
+                    out << (i > 0 ? ", " : "") << v[i];
+                }
+                return out;
+            }
+
+            // functions
+            /*! Compares two vectors using tolerance parameter, see Vec3::Equals */
+            bool Equals(const Vec &v, T tolerance = 0.00001f) const
+            {
+                Vec d = *this - v;
+                return d.Dot(d) <= tolerance;
+            }
+
+            /*! Calculates a dot product between two vectors */
+            T Dot(const Vec &v) const
+            {
+                return VecOps<N, T>::Dot(this->Components(), v.Components());
+            }
+
+            /*! Calculates the vector length */
+            T Length() const
+            {
+                return std::sqrt(Dot(*this));
+            }
+
+            /*! Normalizes the vector */
+            void Normalize()
+            {
+                T magnitude = Length();
+                if(magnitude > 0.0f)
+                {
+                    (*this) *= static_cast<T>(1.0 / magnitude);
+                }
+            }
+    };
+
+    typedef Vec<2, float> Vec2f;	//!< 2d Vector of floats
+    typedef Vec<2, double> Vec2d;	//!< 2d Vector of doubles
+    typedef Vec<2, int> Vec2i;	//!< 2d Vector of integers
+    typedef Vec<4, float> Vec4f;	//!< 4d Vector of floats
+    typedef Vec<4, double> Vec4d;	//!< 4d Vector of doubles
+    typedef Vec<4, int> Vec4i;	//!< 4d Vector of integers
+}
+
+#endif
@@ -0,0 +1,346 @@
+/*! \file format_test.cpp
+  \brief Checks that the text and binary formats of format.h give back the exact values.
+  Every float whose bit pattern is a multiple of the stride, plus the values around every power of two,
+  must survive FormatFloat and ParseFloat bit for bit and fit in MAX_FLOAT_CHARS. Matrix and vector
+  text, Pack/Unpack and StreamWriter output are checked the same way. Prints the failed checks and
+  exits with 1 when there are any:
+  \code
+  g++ -std=c++17 -O2 -Isrc src/[a-z]*.cpp tests/format_test.cpp -o format_test -pthread
+  ./format_test [stride]
+  \endcode
+  A stride of 1 tries all 2^32 floats. Usage is described in tests/README.txt.
+  */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "format.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const uint32_t DEFAULT_STRIDE = 251;
+    const size_t ARRAY_COUNT = 257;
+    const int MAX_REPORTED = 20;
+
+    int failures = 0;
+
+    void Fail(const char *check, uint32_t bits)
+    {
+        if(failures++ < MAX_REPORTED)
+        {
+            printf("failed: %s (0x%08x)\n", check, bits);
+        }
+    }
+
+    float FromBits(uint32_t bits)
+    {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    uint32_t ToBits(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    //! True if the floats have the same bits, or are both NaN
+    bool SameValue(float a, float b)
+    {
+        return ToBits(a) == ToBits(b) || (isnan(a) && isnan(b));
+    }
+
+    //! Formats and parses one float, returns the length of its text
+    size_t CheckFloat(uint32_t bits)
+    {
+        float value = FromBits(bits);
+        // room for longer output than promised, so the length check below can see it
+        char text[2 * MAX_FLOAT_CHARS];
+        char *end = FormatFloat(text, text + sizeof(text), value);
+        float parsed = 0.0f;
+        if(ParseFloat(text, end, parsed) != end)
+        {
+            Fail("ParseFloat stops before the end of FormatFloat output", bits);
+        }
+        if(!SameValue(parsed, value))
+        {
+            Fail("FormatFloat and ParseFloat round trip", bits);
+        }
+        return end - text;
+    }
+
+    void CheckFloats(uint32_t stride, size_t &longest)
+    {
+        uint32_t bits = 0;
+        do
+        {
+            size_t length = CheckFloat(bits);
+            longest = length > longest ? length : longest;
+            bits += stride;
+        }
+        while(bits >= stride);
+
+        // neighbours of every power of two and the largest mantissas, where the shortest form changes length
+        for(uint32_t sign = 0; sign < 2; sign++)
+        {
+            for(uint32_t exponent = 0; exponent < 256; exponent++)
+            {
+                uint32_t power = (sign << 31) | (exponent << 23);
+                const uint32_t mantissas[] = { 0, 1, 2, 0x7ffffe, 0x7fffff, 0x400000, 0x2aaaab, 0x555555 };
+                for(uint32_t mantissa : mantissas)
+                {
+                    size_t length = CheckFloat(power | mantissa);
+                    longest = length > longest ? length : longest;
+                }
+            }
+        }
+        if(longest > MAX_FLOAT_CHARS)
+        {
+            Fail("FormatFloat output longer than MAX_FLOAT_CHARS", static_cast<uint32_t>(longest));
+        }
+    }
+
+    //! Random values of every magnitude, with NaN, infinities, zeroes and denormals
+    float NextValue(mt19937 &engine)
+    {
+        uint32_t bits = engine();
+        switch(engine() % 8)
+        {
+            case 0:
+                return FromBits(bits & 0x807fffffu);
+            case 1:
+                return FromBits((bits & 0x80000000u) | 0x7f800000u | (engine() % 2 ? 0 : 0x400000u | (bits & 0x3fffffu)));
+            default:
+                return FromBits(bits);
+        }
+    }
+
+    void CheckTextArrays(mt19937 &engine)
+    {
+        vector<Mat4> matrices(ARRAY_COUNT), parsedMatrices(ARRAY_COUNT);
+        vector<Vec3f> vectors(ARRAY_COUNT), parsedVectors(ARRAY_COUNT);
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            for(int j = 0; j < 16; j++)
+            {
+                matrices[i].m[j / 4][j % 4] = NextValue(engine);
+            }
+            vectors[i] = Vec3f(NextValue(engine), NextValue(engine), NextValue(engine));
+        }
+
+        vector<char> text(ARRAY_COUNT * MAX_MAT4_CHARS);
+        size_t length = FormatMat4Array(text.data(), text.size(), matrices.data(), ARRAY_COUNT);
+        if(ParseMat4Array(text.data(), text.data() + length, parsedMatrices.data(), ARRAY_COUNT) != text.data() + length)
+        {
+            Fail("ParseMat4Array stops before the end of FormatMat4Array output", 0);
+        }
+        length = FormatVec3Array(text.data(), text.size(), vectors.data(), ARRAY_COUNT);
+        if(ParseVec3Array(text.data(), text.data() + length, parsedVectors.data(), ARRAY_COUNT) != text.data() + length)
+        {
+            Fail("ParseVec3Array stops before the end of FormatVec3Array output", 0);
+        }
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            for(int j = 0; j < 16; j++)
+            {
+                float value = matrices[i].m[j / 4][j % 4];
+                if(!SameValue(parsedMatrices[i].m[j / 4][j % 4], value))
+                {
+                    Fail("FormatMat4Array and ParseMat4Array round trip", ToBits(value));
+                }
+            }
+            for(int j = 0; j < 3; j++)
+            {
+                if(!SameValue(parsedVectors[i][j], vectors[i][j]))
+                {
+                    Fail("FormatVec3Array and ParseVec3Array round trip", ToBits(vectors[i][j]));
+                }
+            }
+        }
+
+        // the layout of operator <<, on values it prints exactly
+        Mat4 matrix;
+        matrix.SetIdentity();
+        matrix.m[3][0] = -2.5f;
+        matrix.m[1][2] = 100.0f;
+        ostringstream streamed;
+        streamed << matrix;
+        char line[MAX_MAT4_CHARS];
+        if(string(line, FormatMat4(line, line + MAX_MAT4_CHARS, matrix)) != streamed.str())
+        {
+            Fail("FormatMat4 layout differs from operator <<", 0);
+        }
+        if(string(line, FormatVec3(line, line + MAX_VEC3_CHARS, Vec3f(1.0f, -0.5f, 1e-45f))) != "1, -0.5, 1e-45\n")
+        {
+            Fail("FormatVec3 layout", 0);
+        }
+
+        // a short buffer throws before writing past its end
+        char small[MAX_VEC3_CHARS + 1];
+        memset(small, '#', sizeof(small));
+        try
+        {
+            FormatMat4(small, small + MAX_VEC3_CHARS, matrices[0]);
+            Fail("FormatMat4 into a short buffer does not throw", 0);
+        }
+        catch(const range_error&)
+        {
+        }
+        if(small[MAX_VEC3_CHARS] != '#')
+        {
+            Fail("FormatMat4 writes past the end of a short buffer", 0);
+        }
+        try
+        {
+            Mat4 matrix;
+            const char malformed[] = "1, 2, x";
+            ParseMat4(malformed, malformed + sizeof(malformed) - 1, matrix);
+            Fail("ParseMat4 accepts malformed text", 0);
+        }
+        catch(const invalid_argument&)
+        {
+        }
+    }
+
+    void CheckPacking(mt19937 &engine)
+    {
+        vector<Mat4> matrices(ARRAY_COUNT), unpackedMatrices(ARRAY_COUNT);
+        vector<Vec3f> vectors(ARRAY_COUNT), unpackedVectors(ARRAY_COUNT);
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            for(int j = 0; j < 16; j++)
+            {
+                matrices[i].m[j / 4][j % 4] = FromBits(engine());
+            }
+            vectors[i] = Vec3f(FromBits(engine()), FromBits(engine()), FromBits(engine()));
+        }
+
+        vector<unsigned char> buffer(ARRAY_COUNT * sizeof(Mat4));
+        size_t size = PackMat4Array(buffer.data(), buffer.size(), matrices.data(), ARRAY_COUNT);
+        if(size != ARRAY_COUNT * 16 * sizeof(float) || UnpackMat4Array(buffer.data(), size, unpackedMatrices.data(), ARRAY_COUNT) != size)
+        {
+            Fail("PackMat4Array and UnpackMat4Array sizes", static_cast<uint32_t>(size));
+        }
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            if(memcmp(unpackedMatrices[i].m, matrices[i].m, sizeof(matrices[i].m)) != 0)
+            {
+                Fail("PackMat4Array and UnpackMat4Array round trip", static_cast<uint32_t>(i));
+            }
+        }
+
+        size = PackVec3Array(buffer.data(), buffer.size(), vectors.data(), ARRAY_COUNT);
+        if(size != ARRAY_COUNT * 3 * sizeof(float) || UnpackVec3Array(buffer.data(), size, unpackedVectors.data(), ARRAY_COUNT) != size)
+        {
+            Fail("PackVec3Array and UnpackVec3Array sizes", static_cast<uint32_t>(size));
+        }
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                if(ToBits(unpackedVectors[i][j]) != ToBits(vectors[i][j]))
+                {
+                    Fail("PackVec3Array and UnpackVec3Array round trip", ToBits(vectors[i][j]));
+                }
+            }
+        }
+
+        try
+        {
+            PackVec3Array(buffer.data(), 3 * sizeof(float) * 2 - 1, vectors.data(), 2);
+            Fail("PackVec3Array into a short buffer does not throw", 0);
+        }
+        catch(const range_error&)
+        {
+        }
+        try
+        {
+            UnpackMat4Array(buffer.data(), 16 * sizeof(float) - 1, unpackedMatrices.data(), 1);
+            Fail("UnpackMat4Array from a short buffer does not throw", 0);
+        }
+        catch(const range_error&)
+        {
+        }
+    }
+
+    //! StreamWriter output must equal the Format functions, whatever the buffer size
+    void CheckStreamWriter(mt19937 &engine)
+    {
+        vector<Mat4> matrices(ARRAY_COUNT);
+        vector<Vec3f> vectors(ARRAY_COUNT);
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            for(int j = 0; j < 16; j++)
+            {
+                matrices[i].m[j / 4][j % 4] = NextValue(engine);
+            }
+            vectors[i] = Vec3f(NextValue(engine), NextValue(engine), NextValue(engine));
+        }
+
+        string expected;
+        char text[MAX_MAT4_CHARS];
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            expected.append(text, FormatMat4(text, text + MAX_MAT4_CHARS, matrices[i]));
+            expected.append(text, FormatVec3(text, text + MAX_VEC3_CHARS, vectors[i]));
+        }
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            expected.append(text, FormatMat4(text, text + MAX_MAT4_CHARS, matrices[i]));
+        }
+        for(size_t i = 0; i < ARRAY_COUNT; i++)
+        {
+            expected.append(text, FormatVec3(text, text + MAX_VEC3_CHARS, vectors[i]));
+        }
+
+        // 0 is raised to MAX_MAT4_CHARS and flushes before every matrix
+        const size_t capacities[] = { 0, MAX_MAT4_CHARS + MAX_VEC3_CHARS / 2, 4096, 64 * 1024 };
+        for(size_t capacity : capacities)
+        {
+            ostringstream out;
+            {
+                StreamWriter writer(out, capacity);
+                for(size_t i = 0; i < ARRAY_COUNT; i++)
+                {
+                    writer.Write(matrices[i]).Write(vectors[i]);
+                }
+                writer.Write(matrices.data(), ARRAY_COUNT);
+                writer.Flush();
+                writer.Write(vectors.data(), ARRAY_COUNT);
+            }
+            if(out.str() != expected)
+            {
+                Fail("StreamWriter output differs from FormatMat4 and FormatVec3", static_cast<uint32_t>(capacity));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t stride = argc > 1 ? static_cast<uint32_t>(strtoul(argv[1], 0, 10)) : DEFAULT_STRIDE;
+    stride = stride > 0 ? stride : 1;
+    mt19937 engine(1);
+
+    size_t longest = 0;
+    CheckFloats(stride, longest);
+    CheckTextArrays(engine);
+    CheckPacking(engine);
+    CheckStreamWriter(engine);
+
+    printf("stride %u, longest float %zu of %zu characters, %d failures\n", stride, longest, MAX_FLOAT_CHARS, failures);
+    return failures == 0 ? 0 : 1;
+}
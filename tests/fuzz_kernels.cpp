@@ -0,0 +1,104 @@
+/*! \file fuzz_kernels.cpp
+  \brief libFuzzer driver which runs every kernel on inputs decoded from raw bytes.
+  Aborts on the first input with a result outside of the tolerance, after printing its report:
+  \code
+  clang++ -std=c++17 -O1 -g -fsanitize=fuzzer,address -Isrc -Itests src/[a-z]*.cpp tests/reference.cpp tests/fuzz_kernels.cpp -o fuzz_kernels -pthread
+  ./fuzz_kernels -max_total_time=600 corpus
+  \endcode
+  Define MATHLIB_FUZZ_STANDALONE to get a main which runs the files given on its command line instead,
+  this replays a saved input with any compiler. Usage is described in tests/README.txt.
+  */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include "reference.h"
+
+#ifdef MATHLIB_FUZZ_STANDALONE
+#include <fstream>
+#include <iterator>
+#include <vector>
+#endif
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    inline float Fraction(float value)
+    {
+        return isfinite(value) ? fabsf(value - truncf(value)) : 0.0f;
+    }
+
+    //! Fills the inputs with floats taken from the bytes in order, wrapping around when they are shorter than needed
+    bool DecodeInputs(const uint8_t *data, size_t size, KernelInputs &in)
+    {
+        const size_t count = size / sizeof(float);
+        if(count == 0)
+        {
+            return false;
+        }
+
+        size_t next = 0;
+        auto value = [&]() {
+            float result;
+            memcpy(&result, data + (next++ % count) * sizeof(float), sizeof(float));
+            return result;
+        };
+
+        for(int i = 0; i < 16; i++)
+        {
+            in.a.m[i / 4][i % 4] = value();
+        }
+        for(int i = 0; i < 16; i++)
+        {
+            in.b.m[i / 4][i % 4] = value();
+        }
+        for(size_t p = 0; p < KERNEL_POINT_COUNT; p++)
+        {
+            float x = value();
+            float y = value();
+            float z = value();
+            in.points[p] = Vec3f(x, y, z);
+        }
+        in.time = value();
+        for(size_t p = 0; p < KERNEL_POINT_COUNT; p++)
+        {
+            in.units[p] = Fraction(value());
+        }
+        return true;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    KernelInputs in;
+    ValidationReport report;
+    if(DecodeInputs(data, size, in) && CheckKernels(in, report) > 0)
+    {
+        fprintf(stderr, "%s\n", ValidationToJson(report).c_str());
+        abort();
+    }
+    return 0;
+}
+
+#ifdef MATHLIB_FUZZ_STANDALONE
+int main(int argc, char **argv)
+{
+    for(int i = 1; i < argc; i++)
+    {
+        ifstream file(argv[i], ios::binary);
+        if(!file)
+        {
+            fprintf(stderr, "cannot open %s\n", argv[i]);
+            return 1;
+        }
+        vector<uint8_t> data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+        LLVMFuzzerTestOneInput(data.data(), data.size());
+    }
+    printf("%d inputs passed\n", argc - 1);
+    return 0;
+}
+#endif
@@ -0,0 +1,373 @@
+/*! \file jobs_test.cpp
+  \brief Checks the asynchronous operations of jobs.h against the serial kernels.
+  Results must equal the serial code bit for bit for every pool size and chunk size, cancelled
+  jobs must stop running chunks and complete with std::runtime_error, and exceptions thrown by
+  tasks and pipeline stages must reach future::get and ChunkPipeline::Pop. Prints the failed
+  checks and exits with 1 when there are any:
+  \code
+  g++ -std=c++17 -O2 -Isrc src/[a-z]*.cpp tests/jobs_test.cpp -o jobs_test -pthread
+  ./jobs_test
+  \endcode
+  Build it with -DMATHLIB_PROFILE as well, the profiler counters then show that cancelled jobs run no kernels.
+  Usage is described in tests/README.txt.
+  */
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <future>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <vector>
+#include "jobs.h"
+#include "functions.h"
+#include "profiler.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const size_t POINT_COUNT = 10007;
+    const size_t MATRIX_COUNT = 1031;
+    const size_t CONTROL_POINT_COUNT = 37;
+    const size_t SAMPLES_PER_SEGMENT = 13;
+    const size_t PIPELINE_CHUNKS = 10;
+    const size_t CANCEL_AFTER = 3;
+
+    int failures = 0;
+
+    void Check(bool condition, const char *check, size_t threads, size_t chunkSize)
+    {
+        if(!condition)
+        {
+            failures++;
+            printf("failed: %s (%zu threads, chunk size %zu)\n", check, threads, chunkSize);
+        }
+    }
+
+    bool SameBits(const void *a, const void *b, size_t size)
+    {
+        return memcmp(a, b, size) == 0;
+    }
+
+#ifdef MATHLIB_PROFILE
+    //! Returns the number of elements processed by all profiled kernels since the last ResetProfile
+    uint64_t GetProcessedItems()
+    {
+        ProfileSnapshot snapshot = GetProfileSnapshot();
+        uint64_t items = 0;
+        for(int kernel = 0; kernel < PROFILE_KERNEL_COUNT; kernel++)
+        {
+            items += snapshot.kernels[kernel].items;
+        }
+        return items;
+    }
+#endif
+
+    //! Returns true if get throws std::runtime_error
+    template<class Result> bool ThrowsRuntimeError(future<Result> &result)
+    {
+        try
+        {
+            result.get();
+        }
+        catch(const runtime_error&)
+        {
+            return true;
+        }
+        catch(...)
+        {
+        }
+        return false;
+    }
+
+    struct Inputs
+    {
+        Affine3x4 affine;
+        vector<Point3f> points;
+        list<Point3f> controlPoints;
+        vector<Mat4> left;
+        vector<Mat4> right;
+        vector<Mat4> rotations;	//!< finite products for ComposeMatricesAsync
+    };
+
+    void Generate(Inputs &in)
+    {
+        mt19937 engine(1);
+        uniform_real_distribution<float> uniform(-10.0f, 10.0f);
+        Mat4 matrix;
+        for(int i = 0; i < 16; i++)
+        {
+            matrix.m[i / 4][i % 4] = uniform(engine);
+        }
+        in.affine = Affine3x4(matrix);
+        for(size_t i = 0; i < POINT_COUNT; i++)
+        {
+            in.points.push_back(Point3f(uniform(engine), uniform(engine), uniform(engine)));
+        }
+        for(size_t i = 0; i < CONTROL_POINT_COUNT; i++)
+        {
+            in.controlPoints.push_back(Point3f(uniform(engine), uniform(engine), uniform(engine)));
+        }
+        for(size_t n = 0; n < MATRIX_COUNT; n++)
+        {
+            Mat4 a, b, rotation, axis;
+            for(int i = 0; i < 16; i++)
+            {
+                a.m[i / 4][i % 4] = uniform(engine);
+                b.m[i / 4][i % 4] = uniform(engine);
+            }
+            in.left.push_back(a);
+            in.right.push_back(b);
+            MatrixRotationX(rotation, uniform(engine));
+            in.rotations.push_back(rotation * MatrixRotationZ(axis, uniform(engine)));
+        }
+    }
+
+    //! Runs every chunked operation and compares it with the serial kernels
+    void CheckResults(ThreadPool &pool, const Inputs &in, size_t chunkSize)
+    {
+        size_t threads = pool.GetThreadCount();
+
+        vector<Point3f> expectedPoints(in.points.size());
+        in.affine.TransformPoints(in.points.data(), expectedPoints.data(), in.points.size());
+        vector<Point3f> points = TransformPointsAsync(pool, in.affine, in.points, CancellationToken(), chunkSize).get();
+        Check(points.size() == expectedPoints.size() && SameBits(points.data(), expectedPoints.data(), points.size() * sizeof(Point3f)),
+                "TransformPointsAsync equals Affine3x4::TransformPoints", threads, chunkSize);
+
+        list<Point3f> controlPoints(in.controlPoints);
+        vector<Point3f> expectedSamples;
+        for(list<Point3f>::iterator item = controlPoints.begin(); item != controlPoints.end(); item++)
+        {
+            for(size_t s = 0; s < SAMPLES_PER_SEGMENT; s++)
+            {
+                expectedSamples.push_back(CatmullRom(controlPoints, item, float(s) / float(SAMPLES_PER_SEGMENT)));
+            }
+        }
+        vector<Point3f> samples = SampleCatmullRomAsync(pool, in.controlPoints, SAMPLES_PER_SEGMENT, CancellationToken(), chunkSize).get();
+        Check(samples.size() == expectedSamples.size() && SameBits(samples.data(), expectedSamples.data(), samples.size() * sizeof(Point3f)),
+                "SampleCatmullRomAsync equals CatmullRom", threads, chunkSize);
+
+        vector<Mat4> expectedProducts;
+        for(size_t i = 0; i < in.left.size(); i++)
+        {
+            Mat4 left(in.left[i]);
+            expectedProducts.push_back(left * in.right[i]);
+        }
+        vector<Mat4> products = MultiplyMatricesAsync(pool, in.left, in.right, CancellationToken(), chunkSize).get();
+        bool same = products.size() == expectedProducts.size();
+        for(size_t i = 0; same && i < products.size(); i++)
+        {
+            same = SameBits(products[i].m, expectedProducts[i].m, sizeof(products[i].m));
+        }
+        Check(same, "MultiplyMatricesAsync equals Mat4::operator *", threads, chunkSize);
+
+        // the serial product grouped by chunks like ComposeMatricesAsync, a single chunk is the sequential loop
+        size_t groupSize = chunkSize > 0 ? chunkSize : DEFAULT_CHUNK_SIZE;
+        Mat4 expectedComposed;
+        expectedComposed.SetIdentity();
+        for(size_t first = 0; first < in.rotations.size(); first += groupSize)
+        {
+            Mat4 product(in.rotations[first]);
+            for(size_t i = first + 1; i < in.rotations.size() && i < first + groupSize; i++)
+            {
+                product = product * in.rotations[i];
+            }
+            expectedComposed = expectedComposed * product;
+        }
+        Mat4 composed = ComposeMatricesAsync(pool, in.rotations, CancellationToken(), chunkSize).get();
+        Check(SameBits(composed.m, expectedComposed.m, sizeof(composed.m)), "ComposeMatricesAsync equals the grouped serial product", threads, chunkSize);
+
+        Mat4 identity;
+        identity.SetIdentity();
+        Mat4 empty = ComposeMatricesAsync(pool, vector<Mat4>(), CancellationToken(), chunkSize).get();
+        Check(SameBits(empty.m, identity.m, sizeof(empty.m)), "ComposeMatricesAsync of no matrices is the identity", threads, chunkSize);
+        Check(TransformPointsAsync(pool, in.affine, vector<Point3f>(), CancellationToken(), chunkSize).get().empty(),
+                "TransformPointsAsync of no points is empty", threads, chunkSize);
+    }
+
+    //! Pushes chunks of points through a pipeline and compares the popped results in order
+    void CheckPipeline(ThreadPool &pool, const Inputs &in)
+    {
+        size_t threads = pool.GetThreadCount();
+        Affine3x4 affine = in.affine;
+        ChunkPipeline<vector<Point3f>, vector<Point3f> > pipeline(pool, [affine](const vector<Point3f> &chunk) {
+            vector<Point3f> out(chunk.size());
+            affine.TransformPoints(chunk.data(), out.data(), chunk.size());
+            return out;
+        }, 3);
+
+        size_t chunkSize = in.points.size() / PIPELINE_CHUNKS + 1;
+        thread producer([&pipeline, &in, chunkSize]() {
+            for(size_t first = 0; first < in.points.size(); first += chunkSize)
+            {
+                size_t last = first + chunkSize < in.points.size() ? first + chunkSize : in.points.size();
+                pipeline.Push(vector<Point3f>(in.points.begin() + first, in.points.begin() + last));
+            }
+            pipeline.Close();
+        });
+
+        vector<Point3f> expected(in.points.size());
+        in.affine.TransformPoints(in.points.data(), expected.data(), in.points.size());
+        vector<Point3f> received, chunk;
+        while(pipeline.Pop(chunk))
+        {
+            received.insert(received.end(), chunk.begin(), chunk.end());
+        }
+        producer.join();
+        Check(received.size() == expected.size() && SameBits(received.data(), expected.data(), received.size() * sizeof(Point3f)),
+                "ChunkPipeline results equal Affine3x4::TransformPoints in order", threads, chunkSize);
+    }
+
+    //! Cancels jobs queued behind a blocked worker, none of their chunks may run
+    void CheckCancelBeforeStart(const Inputs &in)
+    {
+        ThreadPool pool(1);
+        promise<void> gate;
+        shared_future<void> opened = gate.get_future().share();
+        pool.Enqueue([opened]() { opened.wait(); });
+
+        CancellationToken token;
+        future<vector<Point3f> > points = TransformPointsAsync(pool, in.affine, in.points, token, 64);
+        future<vector<Point3f> > samples = SampleCatmullRomAsync(pool, in.controlPoints, SAMPLES_PER_SEGMENT, token, 64);
+        future<vector<Mat4> > products = MultiplyMatricesAsync(pool, in.left, in.right, token, 64);
+        future<Mat4> composed = ComposeMatricesAsync(pool, in.rotations, token, 64);
+
+        atomic<size_t> stageCalls(0);
+        ChunkPipeline<int, int> pipeline(pool, [&stageCalls](const int &value) { stageCalls++; return value; }, PIPELINE_CHUNKS, token);
+        for(size_t i = 0; i < PIPELINE_CHUNKS / 2; i++)
+        {
+            pipeline.Push(int(i));
+        }
+        token.Cancel();
+        Check(!pipeline.Push(0), "ChunkPipeline::Push after cancellation returns false", 1, 64);
+#ifdef MATHLIB_PROFILE
+        ResetProfile();
+#endif
+        gate.set_value();
+
+        Check(ThrowsRuntimeError(points), "cancelled TransformPointsAsync throws std::runtime_error", 1, 64);
+        Check(ThrowsRuntimeError(samples), "cancelled SampleCatmullRomAsync throws std::runtime_error", 1, 64);
+        Check(ThrowsRuntimeError(products), "cancelled MultiplyMatricesAsync throws std::runtime_error", 1, 64);
+        Check(ThrowsRuntimeError(composed), "cancelled ComposeMatricesAsync throws std::runtime_error", 1, 64);
+        int value;
+        Check(!pipeline.Pop(value), "ChunkPipeline::Pop after cancellation returns false", 1, 64);
+        Check(pool.Submit([]() { return 1; }).get() == 1, "the pool runs tasks after cancelled jobs", 1, 64);
+        Check(stageCalls == 0, "no pipeline chunk runs after cancellation", 1, 64);
+#ifdef MATHLIB_PROFILE
+        Check(GetProcessedItems() == 0, "no kernel runs in chunks of cancelled jobs", 1, 64);
+        SampleCatmullRomAsync(pool, in.controlPoints, SAMPLES_PER_SEGMENT, CancellationToken(), 64).get();
+        Check(GetProfileSnapshot().kernels[PROFILE_CATMULL_ROM].items == CONTROL_POINT_COUNT * SAMPLES_PER_SEGMENT,
+                "the profiler counts the CatmullRom calls of a job which is not cancelled", 1, 64);
+#endif
+    }
+
+    //! A stage cancels the pipeline while later chunks are queued on a single worker, they must not run
+    void CheckCancelWhileRunning()
+    {
+        ThreadPool pool(1);
+        promise<void> gate;
+        shared_future<void> opened = gate.get_future().share();
+        pool.Enqueue([opened]() { opened.wait(); });
+
+        CancellationToken token;
+        atomic<size_t> stageCalls(0);
+        ChunkPipeline<int, int> pipeline(pool, [&stageCalls, token](const int &value) mutable {
+            if(++stageCalls == CANCEL_AFTER)
+            {
+                token.Cancel();
+            }
+            return value;
+        }, PIPELINE_CHUNKS, token);
+        for(size_t i = 0; i < PIPELINE_CHUNKS; i++)
+        {
+            pipeline.Push(int(i));
+        }
+        gate.set_value();
+        Check(pool.Submit([]() { return 1; }).get() == 1, "the pool runs tasks after a cancelled pipeline", 1, 1);
+        Check(stageCalls == CANCEL_AFTER, "chunks queued behind a cancelling chunk do not run", 1, 1);
+    }
+
+    void CheckExceptions(ThreadPool &pool)
+    {
+        size_t threads = pool.GetThreadCount();
+        future<int> failed = pool.Submit([]() -> int { throw invalid_argument("task failed"); });
+        bool caught = false;
+        try
+        {
+            failed.get();
+        }
+        catch(const invalid_argument &error)
+        {
+            caught = strcmp(error.what(), "task failed") == 0;
+        }
+        Check(caught, "an exception of a task reaches future::get", threads, 0);
+        Check(pool.Submit([]() { return 2; }).get() == 2, "the pool runs tasks after a task threw", threads, 0);
+
+        // only the failing chunk is lost, later chunks still arrive in order
+        ChunkPipeline<int, int> pipeline(pool, [](const int &value) {
+            if(value == 1)
+            {
+                throw invalid_argument("stage failed");
+            }
+            return 10 * value;
+        }, PIPELINE_CHUNKS);
+        for(int i = 0; i < 3; i++)
+        {
+            pipeline.Push(i);
+        }
+        pipeline.Close();
+        int first = -1, last = -1;
+        caught = false;
+        bool popped = pipeline.Pop(first);
+        try
+        {
+            int value;
+            pipeline.Pop(value);
+        }
+        catch(const invalid_argument &error)
+        {
+            caught = strcmp(error.what(), "stage failed") == 0;
+        }
+        popped = popped && pipeline.Pop(last);
+        Check(popped && first == 0 && last == 20, "ChunkPipeline::Pop delivers the chunks around a failed one", threads, 0);
+        Check(caught, "an exception of a pipeline stage reaches ChunkPipeline::Pop", threads, 0);
+
+        caught = false;
+        try
+        {
+            MultiplyMatricesAsync(pool, vector<Mat4>(2), vector<Mat4>(3));
+        }
+        catch(const invalid_argument&)
+        {
+            caught = true;
+        }
+        Check(caught, "MultiplyMatricesAsync throws std::invalid_argument for different sizes", threads, 0);
+    }
+}
+
+int main()
+{
+    Inputs in;
+    Generate(in);
+
+    const size_t threadCounts[] = { 1, 3, 0 };
+    const size_t chunkSizes[] = { 0, 1, 7, 100, POINT_COUNT + 5 };
+    for(size_t threadCount : threadCounts)
+    {
+        ThreadPool pool(threadCount);
+        for(size_t chunkSize : chunkSizes)
+        {
+            CheckResults(pool, in, chunkSize);
+        }
+        CheckPipeline(pool, in);
+        CheckExceptions(pool);
+    }
+    CheckCancelBeforeStart(in);
+    CheckCancelWhileRunning();
+
+    printf("%d failures\n", failures);
+    return failures == 0 ? 0 : 1;
+}
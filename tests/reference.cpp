@@ -0,0 +1,1220 @@
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "reference.h"
+#include "color.h"
+#include "decompose.h"
+#include "functions.h"
+#include "projection.h"
+#include "track.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const char* KERNEL_NAMES[VALIDATE_KERNEL_COUNT] =
+    {
+        "mat4_multiply",
+        "vec3_transform",
+        "vec4_dot",
+        "vec4_arithmetic",
+        "affine_transform_batch",
+        "homogeneous_transform_batch",
+        "perspective_divide_batch",
+        "clip_flags_batch",
+        "affine_multiply",
+        "affine_inverse",
+        "mat2_multiply",
+        "mat2_inverse",
+        "mat3_multiply",
+        "mat3_inverse",
+        "catmull_rom",
+        "bezier",
+        "linear_interpolation",
+        "normal_matrix_batch",
+        "srgb_decode_batch",
+        "srgb_encode_batch",
+        "srgb_knee_monotonic",
+        "blend_batch",
+        "multiply_add_colors_batch",
+        "clamp_colors_batch",
+        "pack_rgba8_batch",
+        "pack_rgba8_srgb_batch",
+        "unpack_rgba8_batch",
+        "color_planes",
+        "color3_batch",
+        "decompose_lu",
+        "solve",
+        "decompose_qr",
+        "decompose_polar",
+        "eigen_symmetric",
+        "track_decode"
+    };
+
+    const double ARITHMETIC_TOLERANCE = 8.0 * FLT_EPSILON;
+    const double CURVE_TOLERANCE = 32.0 * FLT_EPSILON;
+    // relative to the expected value, the batch curves stay below 2e-6
+    const double SRGB_TOLERANCE = 1e-4;
+    // half a byte step plus the rounding of the scaled value
+    const double PACK_TOLERANCE = 0.5 + 256.0 * FLT_EPSILON;
+    // the packed sRGB bytes follow the float curve, which is a few ULPs off the exact one
+    const double SRGB_PACK_TOLERANCE = 0.5 + 1024.0 * FLT_EPSILON;
+    const double DECOMPOSITION_TOLERANCE = 16.0 * FLT_EPSILON;
+    const double ABSOLUTE_FLOOR = 32.0 * FLT_TRUE_MIN;
+    // rounding error of a denormal product expressed in units of the machine epsilon
+    const double UNDERFLOW_TERM = FLT_TRUE_MIN / FLT_EPSILON;
+    const float SRGB_DECODE_KNEE = 0.04045f;
+    const float SRGB_ENCODE_KNEE = 0.0031308f;
+    // floats checked on each side of a knee
+    const int KNEE_WINDOW = 4096;
+
+    inline double Term(double value, bool absolute)
+    {
+        return absolute ? fabs(value) : value;
+    }
+
+    //! Turns a magnitude into infinity when a float intermediate would overflow
+    inline double Bounded(double value, bool absolute)
+    {
+        return absolute && fabs(value) > FLT_MAX ? INFINITY : value;
+    }
+
+    //! Turns a magnitude into infinity when a float weight would overflow or lose its precision to underflow
+    inline double Weight(double value, bool absolute)
+    {
+        return absolute && value != 0.0 && (fabs(value) > FLT_MAX || fabs(value) < FLT_MIN) ? INFINITY : value;
+    }
+
+    inline float NotNan(float value)
+    {
+        return isnan(value) ? 0.0f : value;
+    }
+
+    void WriteNumber(ostringstream &out, double value)
+    {
+        if(isfinite(value))
+        {
+            out << value;
+        }
+        else
+        {
+            out << "null";
+        }
+    }
+
+    void Compare(ErrorStats &stats, const float *actual, const double *expected, const double *magnitude, size_t count, double tolerance)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            stats.Add(actual[i], expected[i], magnitude[i], tolerance);
+        }
+    }
+
+    /*! Divides cofactors by the determinant, giving the first order error bound of every result divided by the machine epsilon
+      \param cofactorMagnitude Error bounds of the cofactors divided by the machine epsilon
+      \param detMagnitude Error bound of the determinant divided by the machine epsilon
+      */
+    void DivideCofactors(const double *cofactor, const double *cofactorMagnitude, size_t count, double det, double detMagnitude,
+            double *result, double *magnitude)
+    {
+        // the float code has no meaningful result when the determinant leaves the normal float range,
+        // and the first order bound does not hold once the rounding error of the determinant approaches its value
+        bool representable = fabs(det) >= FLT_MIN && 1.0 / fabs(det) >= FLT_MIN && detMagnitude <= FLT_MAX &&
+            16.0 * FLT_EPSILON * detMagnitude < fabs(det);
+        for(size_t i = 0; i < count; i++)
+        {
+            representable = representable && cofactorMagnitude[i] <= FLT_MAX;
+        }
+        for(size_t i = 0; i < count; i++)
+        {
+            result[i] = det != 0.0 ? cofactor[i] / det : cofactor[i];
+            if(magnitude)
+            {
+                // first order bound of c / d with errors in both the cofactor and the determinant
+                magnitude[i] = representable ? cofactorMagnitude[i] / fabs(det) + fabs(cofactor[i]) * detMagnitude / (det * det) : INFINITY;
+            }
+        }
+    }
+
+    //! Returns the upper left NxN part of a 4x4 matrix
+    template<int N> Mat<N, N, float> UpperLeft(const Mat4 &matrix)
+    {
+        Mat<N, N, float> result;
+        for(int i = 0; i < N; i++)
+        {
+            for(int j = 0; j < N; j++)
+            {
+                result.m[i][j] = matrix.m[i][j];
+            }
+        }
+        return result;
+    }
+
+    //! Computes a * b for NxN matrices the way Mat::operator * does
+    template<int N> void MultiplyNxN(const Mat<N, N, float> &a, const Mat<N, N, float> &b, double result[N][N], bool absolute)
+    {
+        for(int i = 0; i < N; i++)
+        {
+            for(int j = 0; j < N; j++)
+            {
+                double sum = 0.0;
+                for(int k = 0; k < N; k++)
+                {
+                    sum += Term(double(b.m[i][k]) * a.m[k][j], absolute);
+                }
+                result[i][j] = sum;
+            }
+        }
+    }
+
+    //! Returns matrix.Inverted(), filled with NaN when it reports a singular matrix so that the result only passes where the reference is skipped
+    template<class Matrix> Matrix InvertedOrNan(const Matrix &matrix)
+    {
+        try
+        {
+            return matrix.Inverted();
+        }
+        catch(const domain_error&)
+        {
+            Matrix result;
+            float *values = &result.m[0][0];
+            for(size_t i = 0; i < sizeof(result.m) / sizeof(float); i++)
+            {
+                values[i] = NAN;
+            }
+            return result;
+        }
+    }
+
+    void CheckArithmetic(const KernelInputs &in, ValidationReport &report)
+    {
+        double expected[4][4], magnitude[4][4];
+
+        Mat4 left(in.a);
+        Mat4 product = left * in.b;
+        ReferenceMultiply(in.a, in.b, expected);
+        ReferenceMultiply(in.a, in.b, magnitude, true);
+        Compare(report.kernels[VALIDATE_MAT4_MULTIPLY], product.m[0], expected[0], magnitude[0], 16, ARITHMETIC_TOLERANCE);
+
+        for(size_t i = 0; i < KERNEL_POINT_COUNT; i++)
+        {
+            Vec3f transformed(in.points[i]);
+            transformed.Transform(in.a);
+            ReferenceTransform(in.a, in.points[i], expected[0]);
+            ReferenceTransform(in.a, in.points[i], magnitude[0], true);
+            Compare(report.kernels[VALIDATE_VEC3_TRANSFORM], &transformed.x, expected[0], magnitude[0], 3, ARITHMETIC_TOLERANCE);
+
+            Vec4f row(in.a.m[i][0], in.a.m[i][1], in.a.m[i][2], in.a.m[i][3]);
+            Vec4f column(in.b.m[0][i], in.b.m[1][i], in.b.m[2][i], in.b.m[3][i]);
+            double dot = 0.0, dotMagnitude = 0.0;
+            for(int k = 0; k < 4; k++)
+            {
+                dot += double(row[k]) * column[k];
+                dotMagnitude += fabs(double(row[k]) * column[k]);
+            }
+            report.kernels[VALIDATE_VEC4_DOT].Add(row.Dot(column), dot, dotMagnitude, ARITHMETIC_TOLERANCE);
+
+            // every component is a single operation, so the double result rounds to the same float
+            float scalar = in.b.m[i][i];
+            const Vec4f results[5] = { row + column, row - column, row * column, row / column, row * scalar };
+            for(int k = 0; k < 4; k++)
+            {
+                double x = row[k], y = column[k];
+                const double exact[5] = { x + y, x - y, x * y, x / y, x * scalar };
+                for(int op = 0; op < 5; op++)
+                {
+                    report.kernels[VALIDATE_VEC4_ARITHMETIC].AddExact(results[op][k], static_cast<float>(exact[op]));
+                }
+            }
+        }
+
+        Vec3f affinePoints[KERNEL_POINT_COUNT];
+        Affine3x4(in.a).TransformPoints(in.points, affinePoints, KERNEL_POINT_COUNT);
+        Point4f homogeneous[KERNEL_POINT_COUNT], fused[KERNEL_POINT_COUNT];
+        unsigned char flags[KERNEL_POINT_COUNT], fusedFlags[KERNEL_POINT_COUNT];
+        Point3f divided[KERNEL_POINT_COUNT];
+        TransformHomogeneous(in.a, in.points, homogeneous, KERNEL_POINT_COUNT);
+        TransformHomogeneous(in.a, in.points, fused, fusedFlags, KERNEL_POINT_COUNT);
+        ComputeClipFlags(homogeneous, flags, KERNEL_POINT_COUNT);
+        PerspectiveDivide(homogeneous, divided, KERNEL_POINT_COUNT);
+        for(size_t i = 0; i < KERNEL_POINT_COUNT; i++)
+        {
+            ReferenceHomogeneous(in.a, in.points[i], expected[0]);
+            ReferenceHomogeneous(in.a, in.points[i], magnitude[0], true);
+            Compare(report.kernels[VALIDATE_AFFINE_TRANSFORM_BATCH], &affinePoints[i].x, expected[0], magnitude[0], 3, ARITHMETIC_TOLERANCE);
+            Compare(report.kernels[VALIDATE_HOMOGENEOUS_TRANSFORM_BATCH], &homogeneous[i].x, expected[0], magnitude[0], 4, ARITHMETIC_TOLERANCE);
+
+            ReferencePerspectiveDivide(homogeneous[i], expected[0], magnitude[0]);
+            Compare(report.kernels[VALIDATE_PERSPECTIVE_DIVIDE_BATCH], &divided[i].x, expected[0], magnitude[0], 3, ARITHMETIC_TOLERANCE);
+
+            // flags are compared as numbers without tolerance, so any difference fails
+            report.kernels[VALIDATE_CLIP_FLAGS_BATCH].Add(flags[i], ReferenceClipFlags(homogeneous[i]), 0.0, 0.0);
+            report.kernels[VALIDATE_CLIP_FLAGS_BATCH].Add(fusedFlags[i], ReferenceClipFlags(fused[i]), 0.0, 0.0);
+        }
+    }
+
+    void CheckMatrices(const KernelInputs &in, ValidationReport &report)
+    {
+        double expected[4][4], magnitude[4][4];
+        const Affine3x4 a(in.a), b(in.b);
+        const Mat4 left = a.ToMat4(), right = b.ToMat4();
+
+        // each of the three affine products has its own code
+        Affine3x4 product = a * b;
+        ReferenceMultiply(left, right, expected);
+        ReferenceMultiply(left, right, magnitude, true);
+        for(int i = 0; i < 4; i++)
+        {
+            Compare(report.kernels[VALIDATE_AFFINE_MULTIPLY], product.m[i], expected[i], magnitude[i], 3, ARITHMETIC_TOLERANCE);
+        }
+
+        Mat4 mixed = a * in.b;
+        ReferenceMultiply(left, in.b, expected);
+        ReferenceMultiply(left, in.b, magnitude, true);
+        Compare(report.kernels[VALIDATE_AFFINE_MULTIPLY], mixed.m[0], expected[0], magnitude[0], 16, ARITHMETIC_TOLERANCE);
+
+        mixed = in.a * b;
+        ReferenceMultiply(in.a, right, expected);
+        ReferenceMultiply(in.a, right, magnitude, true);
+        Compare(report.kernels[VALIDATE_AFFINE_MULTIPLY], mixed.m[0], expected[0], magnitude[0], 16, ARITHMETIC_TOLERANCE);
+
+        Affine3x4 inverse = InvertedOrNan(a);
+        double affineExpected[4][3], affineMagnitude[4][3];
+        ReferenceInverse(a, affineExpected, affineMagnitude);
+        Compare(report.kernels[VALIDATE_AFFINE_INVERSE], inverse.m[0], affineExpected[0], affineMagnitude[0], 12, ARITHMETIC_TOLERANCE);
+
+        const Mat2 a2 = UpperLeft<2>(in.a), b2 = UpperLeft<2>(in.b);
+        Mat2 product2 = a2 * b2;
+        double expected2[2][2], magnitude2[2][2];
+        ReferenceMultiply(a2, b2, expected2);
+        ReferenceMultiply(a2, b2, magnitude2, true);
+        Compare(report.kernels[VALIDATE_MAT2_MULTIPLY], product2.m[0], expected2[0], magnitude2[0], 4, ARITHMETIC_TOLERANCE);
+        Mat2 inverse2 = InvertedOrNan(a2);
+        ReferenceInverse(a2, expected2, magnitude2);
+        Compare(report.kernels[VALIDATE_MAT2_INVERSE], inverse2.m[0], expected2[0], magnitude2[0], 4, ARITHMETIC_TOLERANCE);
+
+        const Mat3 a3 = UpperLeft<3>(in.a), b3 = UpperLeft<3>(in.b);
+        Mat3 product3 = a3 * b3;
+        double expected3[3][3], magnitude3[3][3];
+        ReferenceMultiply(a3, b3, expected3);
+        ReferenceMultiply(a3, b3, magnitude3, true);
+        Compare(report.kernels[VALIDATE_MAT3_MULTIPLY], product3.m[0], expected3[0], magnitude3[0], 9, ARITHMETIC_TOLERANCE);
+        Mat3 inverse3 = InvertedOrNan(a3);
+        ReferenceInverse(a3, expected3, magnitude3);
+        Compare(report.kernels[VALIDATE_MAT3_INVERSE], inverse3.m[0], expected3[0], magnitude3[0], 9, ARITHMETIC_TOLERANCE);
+    }
+
+    void CheckCurves(const KernelInputs &in, ValidationReport &report)
+    {
+        double expected[3], magnitude[3];
+        list<Point3f> points(in.points, in.points + KERNEL_POINT_COUNT);
+
+        list<Point3f>::iterator second = ++points.begin();
+        Point3f catmullRom = CatmullRom(points, second, in.time);
+        ReferenceCatmullRom(in.points, in.time, expected);
+        ReferenceCatmullRom(in.points, in.time, magnitude, true);
+        Compare(report.kernels[VALIDATE_CATMULL_ROM], &catmullRom.x, expected, magnitude, 3, CURVE_TOLERANCE);
+
+        list<Point3f>::iterator first = points.begin();
+        Point3f bezier = Bezier(points, first, in.time);
+        ReferenceBezier(in.points, in.time, expected);
+        ReferenceBezier(in.points, in.time, magnitude, true);
+        Compare(report.kernels[VALIDATE_BEZIER], &bezier.x, expected, magnitude, 3, CURVE_TOLERANCE);
+
+        Point3f linear = LinearInterpolation(points, points.begin(), in.time);
+        ReferenceLinearInterpolation(in.points, in.time, expected);
+        ReferenceLinearInterpolation(in.points, in.time, magnitude, true);
+        Compare(report.kernels[VALIDATE_LINEAR_INTERPOLATION], &linear.x, expected, magnitude, 3, CURVE_TOLERANCE);
+    }
+
+    void CheckNormalMatrices(const KernelInputs &in, ValidationReport &report)
+    {
+        const Mat4 matrices[2] = { in.a, in.b };
+        Mat3 normals[2];
+        NormalMatrices(matrices, normals, 2);
+        for(int i = 0; i < 2; i++)
+        {
+            double expected[3][3], magnitude[3][3];
+            ReferenceNormalMatrix(matrices[i], expected, magnitude);
+            Compare(report.kernels[VALIDATE_NORMAL_MATRIX_BATCH], normals[i].m[0], expected[0], magnitude[0], 9, ARITHMETIC_TOLERANCE);
+        }
+    }
+
+    void CheckColors(const KernelInputs &in, ValidationReport &report)
+    {
+        Color4f decoded(in.units[0], in.units[1], in.units[2], in.units[3]);
+        Color4f encoded(decoded);
+        SrgbToLinear(&decoded, 1);
+        LinearToSrgb(&encoded, 1);
+
+        const float *channels[2] = { &decoded.r, &encoded.r };
+        for(int c = 0; c < 3; c++)
+        {
+            double linear = ReferenceSrgbToLinear(in.units[c]);
+            double srgb = ReferenceLinearToSrgb(in.units[c]);
+            report.kernels[VALIDATE_SRGB_DECODE_BATCH].Add(channels[0][c], linear, fabs(linear), SRGB_TOLERANCE);
+            report.kernels[VALIDATE_SRGB_ENCODE_BATCH].Add(channels[1][c], srgb, fabs(srgb), SRGB_TOLERANCE);
+        }
+
+        // colors built from points leave [0, 1], which also covers the clamping of PackRGBA8
+        const Color4f sources[2] =
+        {
+            Color4f(in.units[0], in.units[1], in.units[2], in.units[3]),
+            Color4f(NotNan(in.points[0].x), NotNan(in.points[0].y), NotNan(in.points[0].z), in.units[0])
+        };
+        const Color4f destinations[2] =
+        {
+            Color4f(NotNan(in.points[1].x), NotNan(in.points[1].y), NotNan(in.points[1].z), in.units[1]),
+            Color4f(in.units[3], in.units[2], in.units[1], in.units[2])
+        };
+        Color4f blended[2] = { destinations[0], destinations[1] };
+        BlendColors(sources, blended, 2);
+
+        // packing also gets the values which are not numbers
+        const Color4f packSources[3] = { sources[0], sources[1], Color4f(NAN, INFINITY, -INFINITY, NAN) };
+        uint32_t packed[2][3];
+        PackRGBA8(packSources, packed[0], 3);
+        PackRGBA8(packSources, packed[1], 3, true);
+
+        // factors taken from the points move the results out of [0, 1], which the clamp then gets
+        const Color4f multiplier(NotNan(in.points[2].x), NotNan(in.points[2].y), NotNan(in.points[2].z), in.time);
+        const Color4f addend(NotNan(in.points[3].x), NotNan(in.points[3].y), NotNan(in.points[3].z), -in.units[3]);
+        Color4f scaled[2] = { sources[0], sources[1] };
+        MultiplyAddColors(scaled, 2, multiplier, addend);
+        Color4f clamped[2] = { scaled[0], scaled[1] };
+        ClampColors(clamped, 2);
+
+        // the bits of a matrix row give every byte value over the iterations
+        uint32_t words[4];
+        memcpy(words, in.a.m[0], sizeof(words));
+        Color4f unpacked[2][4];
+        UnpackRGBA8(words, unpacked[0], 4);
+        UnpackRGBA8(words, unpacked[1], 4, true);
+
+        double expected[4], magnitude[4];
+        for(int i = 0; i < 2; i++)
+        {
+            ReferenceBlend(sources[i], destinations[i], expected);
+            ReferenceBlend(sources[i], destinations[i], magnitude, true);
+            Compare(report.kernels[VALIDATE_BLEND_BATCH], &blended[i].r, expected, magnitude, 4, ARITHMETIC_TOLERANCE);
+        }
+        for(int srgb = 0; srgb < 2; srgb++)
+        {
+            ErrorStats &packStats = report.kernels[srgb ? VALIDATE_PACK_RGBA8_SRGB_BATCH : VALIDATE_PACK_RGBA8_BATCH];
+            for(int i = 0; i < 3; i++)
+            {
+                ReferencePack(packSources[i], expected, srgb != 0);
+                for(int c = 0; c < 4; c++)
+                {
+                    float byte = static_cast<float>((packed[srgb][i] >> (8 * c)) & 0xFF);
+                    packStats.Add(byte, expected[c], 1.0, srgb ? SRGB_PACK_TOLERANCE : PACK_TOLERANCE);
+                }
+            }
+            for(int i = 0; i < 4; i++)
+            {
+                ReferenceUnpack(words[i], expected, srgb != 0);
+                Compare(report.kernels[VALIDATE_UNPACK_RGBA8_BATCH], &unpacked[srgb][i].r, expected, expected, 4,
+                        srgb ? SRGB_TOLERANCE : ARITHMETIC_TOLERANCE);
+            }
+        }
+
+        const float *factors = &multiplier.r;
+        const float *terms = &addend.r;
+        for(int i = 0; i < 2; i++)
+        {
+            const float *source = &sources[i].r;
+            const float *result = &scaled[i].r;
+            const float *clampedResult = &clamped[i].r;
+            for(int c = 0; c < 4; c++)
+            {
+                double product = double(source[c]) * factors[c];
+                report.kernels[VALIDATE_MULTIPLY_ADD_COLORS_BATCH].Add(result[c], product + terms[c], fabs(product) + fabs(terms[c]), ARITHMETIC_TOLERANCE);
+                float value = result[c];
+                report.kernels[VALIDATE_CLAMP_COLORS_BATCH].AddExact(clampedResult[c], value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f);
+            }
+        }
+    }
+
+    void CompareExact(ErrorStats &stats, const float *actual, const float *expected, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            stats.AddExact(actual[i], expected[i]);
+        }
+    }
+
+    //! Compares the planes with the Color4f array after the same operation
+    void ComparePlanes(ErrorStats &stats, const ColorPlanes &planes, const Color4f *colors)
+    {
+        vector<Color4f> stored(planes.GetSize());
+        planes.Store(stored.data());
+        CompareExact(stats, &stored[0].r, &colors[0].r, 4 * stored.size());
+    }
+
+    //! Compares r, g and b of the Color3f array with the Color4f array after the same operation
+    void CompareColor3(ErrorStats &stats, const Color3f *colors, const Color4f *expected, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            CompareExact(stats, &colors[i].r, &expected[i].r, 3);
+        }
+    }
+
+    //! Compares the bytes of words packed from Color3f arrays with words packed from Color4f arrays, alpha is 255
+    void CompareColor3(ErrorStats &stats, const uint32_t *packed, const uint32_t *expected, size_t count)
+    {
+        for(size_t i = 0; i < count; i++)
+        {
+            uint32_t word = (expected[i] & 0x00FFFFFFu) | 0xFF000000u;
+            for(int c = 0; c < 4; c++)
+            {
+                stats.AddExact(static_cast<float>((packed[i] >> (8 * c)) & 0xFF), static_cast<float>((word >> (8 * c)) & 0xFF));
+            }
+        }
+    }
+
+    /*! Runs the color operations on planes and Color3f arrays, and compares them with the Color4f operations.
+      Six pixels run four at a time in SSE registers and two in the scalar tail
+      */
+    void CheckColorLayouts(const KernelInputs &in, ValidationReport &report)
+    {
+        const size_t count = 6;
+        Color4f colors[count], sources[count];
+        for(size_t i = 0; i < count; i++)
+        {
+            const float *units = in.units;
+            const Vec3f &point = in.points[i % KERNEL_POINT_COUNT];
+            colors[i] = i < KERNEL_POINT_COUNT ? Color4f(units[i], units[(i + 1) % 4], units[(i + 2) % 4], units[(i + 3) % 4]) :
+                Color4f(point.x, point.y, point.z, units[i % 4]);
+            sources[i] = Color4f(in.a.m[i % 4][0], in.a.m[i % 4][1], in.a.m[i % 4][2], units[(i + 1) % 4]);
+        }
+        const Color4f multiplier(in.b.m[0][0], in.b.m[0][1], in.b.m[0][2], in.b.m[0][3]);
+        const Color4f addend(in.b.m[1][0], in.b.m[1][1], in.b.m[1][2], in.b.m[1][3]);
+
+        ErrorStats &planeStats = report.kernels[VALIDATE_COLOR_PLANES];
+        ColorPlanes planes, sourcePlanes;
+        planes.Load(colors, count);
+        sourcePlanes.Load(sources, count);
+        planes.Blend(sourcePlanes);
+        BlendColors(sources, colors, count);
+        ComparePlanes(planeStats, planes, colors);
+
+        ErrorStats &color3Stats = report.kernels[VALIDATE_COLOR3_BATCH];
+        Color3f colors3[count];
+        for(size_t i = 0; i < count; i++)
+        {
+            colors3[i] = Color3f(colors[i].r, colors[i].g, colors[i].b);
+        }
+
+        planes.MultiplyAdd(multiplier, addend);
+        MultiplyAddColors(colors, count, multiplier, addend);
+        MultiplyAddColors(colors3, count, Color3f(multiplier.r, multiplier.g, multiplier.b), Color3f(addend.r, addend.g, addend.b));
+        ComparePlanes(planeStats, planes, colors);
+        CompareColor3(color3Stats, colors3, colors, count);
+
+        uint32_t packed[2][count], packed3[2][count];
+        for(int srgb = 0; srgb < 2; srgb++)
+        {
+            PackRGBA8(colors, packed[srgb], count, srgb != 0);
+            PackRGBA8(colors3, packed3[srgb], count, srgb != 0);
+            CompareColor3(color3Stats, packed3[srgb], packed[srgb], count);
+        }
+
+        planes.Clamp();
+        ClampColors(colors, count);
+        ClampColors(colors3, count);
+        ComparePlanes(planeStats, planes, colors);
+        CompareColor3(color3Stats, colors3, colors, count);
+
+        planes.LinearToSrgb();
+        LinearToSrgb(colors, count);
+        LinearToSrgb(colors3, count);
+        ComparePlanes(planeStats, planes, colors);
+        CompareColor3(color3Stats, colors3, colors, count);
+
+        planes.SrgbToLinear();
+        SrgbToLinear(colors, count);
+        SrgbToLinear(colors3, count);
+        ComparePlanes(planeStats, planes, colors);
+        CompareColor3(color3Stats, colors3, colors, count);
+
+        for(int srgb = 0; srgb < 2; srgb++)
+        {
+            UnpackRGBA8(packed[srgb], colors, count, srgb != 0);
+            UnpackRGBA8(packed[srgb], colors3, count, srgb != 0);
+            CompareColor3(color3Stats, colors3, colors, count);
+        }
+    }
+
+    double FrobeniusNorm3x3(const Mat4 &matrix)
+    {
+        double sum = 0.0;
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                sum += double(matrix.m[i][j]) * matrix.m[i][j];
+            }
+        }
+        return sqrt(sum);
+    }
+
+    //! Returns the Frobenius norm condition number of the 3x3 part, infinite for singular matrices
+    double ConditionNumber3x3(const Mat4 &matrix)
+    {
+        double cofactor[3][3];
+        double adjugate = 0.0;
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                const float *u = matrix.m[(i + 1) % 3];
+                const float *v = matrix.m[(i + 2) % 3];
+                cofactor[i][j] = double(u[(j + 1) % 3]) * v[(j + 2) % 3] - double(u[(j + 2) % 3]) * v[(j + 1) % 3];
+                adjugate += cofactor[i][j] * cofactor[i][j];
+            }
+        }
+        double det = matrix.m[0][0] * cofactor[0][0] + matrix.m[0][1] * cofactor[0][1] + matrix.m[0][2] * cofactor[0][2];
+        return det != 0.0 ? FrobeniusNorm3x3(matrix) * sqrt(adjugate) / fabs(det) : INFINITY;
+    }
+
+    //! Compares the 3x3 part of a reconstructed matrix with the original, errors are relative to the norm of the original
+    void CheckResidual(ErrorStats &stats, const Mat4 &reconstructed, const Mat4 &original, double tolerance)
+    {
+        double norm = FrobeniusNorm3x3(original);
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                stats.Add(reconstructed.m[i][j], original.m[i][j], norm, tolerance);
+            }
+        }
+    }
+
+    //! Compares the dot products of pairs of 3x3 rows, or columns if columns is true, with the identity
+    void CheckOrthogonality(ErrorStats &stats, const Mat4 &matrix, bool columns, double magnitude, double tolerance)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            for(int j = 0; j < 3; j++)
+            {
+                double dot = 0.0;
+                for(int k = 0; k < 3; k++)
+                {
+                    dot += columns ? double(matrix.m[k][i]) * matrix.m[k][j] : double(matrix.m[i][k]) * matrix.m[j][k];
+                }
+                stats.Add(static_cast<float>(dot), i == j ? 1.0 : 0.0, magnitude, tolerance);
+            }
+        }
+    }
+
+    /*! Multiplies the factors of DecomposeLU. bound receives |L| |U| plus UNDERFLOW_TERM for every elimination
+      step, which may underflow, and UNDERFLOW_TERM |U| for multipliers which underflow
+      */
+    void MultiplyLU(const Mat4 &lu, double product[4][4], double bound[4][4])
+    {
+        for(int i = 0; i < 4; i++)
+        {
+            for(int j = 0; j < 4; j++)
+            {
+                product[i][j] = 0.0;
+                bound[i][j] = 0.0;
+                for(int k = 0; k <= i && k <= j; k++)
+                {
+                    double term = (k == i ? 1.0 : double(lu.m[i][k])) * lu.m[k][j];
+                    product[i][j] += term;
+                    bound[i][j] += fabs(term) + UNDERFLOW_TERM * (1.0 + (k < i ? fabs(lu.m[k][j]) : 0.0));
+                }
+            }
+        }
+    }
+
+    //! Swaps rows of a matrix and a vector the way DecomposeLU does
+    void PermuteRows(const int pivot[4], Mat4 &matrix, float vector[4])
+    {
+        for(int k = 0; k < 4; k++)
+        {
+            for(int j = 0; j < 4; j++)
+            {
+                swap(matrix.m[k][j], matrix.m[pivot[k]][j]);
+            }
+            swap(vector[k], vector[pivot[k]]);
+        }
+    }
+
+    /*! Checks DecomposeLU by the residual of P A = L U and Solve by the residual of A x = b, both relative to |L| |U|,
+      which bounds the backward error of elimination
+      */
+    void CheckLinearSolvers(const Mat4 &matrix, const Point4f &b, ValidationReport &report)
+    {
+        Mat4 lu(matrix);
+        int pivot[4];
+        if(!DecomposeLU(lu, pivot))
+        {
+            return;
+        }
+
+        double product[4][4], bound[4][4];
+        MultiplyLU(lu, product, bound);
+        Mat4 permuted(matrix);
+        float permutedB[4] = { b.x, b.y, b.z, b.w };
+        PermuteRows(pivot, permuted, permutedB);
+        for(int i = 0; i < 4; i++)
+        {
+            for(int j = 0; j < 4; j++)
+            {
+                report.kernels[VALIDATE_DECOMPOSE_LU].Add(permuted.m[i][j], product[i][j], bound[i][j], DECOMPOSITION_TOLERANCE);
+            }
+        }
+
+        Point4f x;
+        if(!Solve(matrix, b, x))
+        {
+            report.kernels[VALIDATE_SOLVE].failures++;
+            return;
+        }
+        for(int i = 0; i < 4; i++)
+        {
+            double residual = 0.0, magnitude = 0.0;
+            for(int j = 0; j < 4; j++)
+            {
+                residual += double(permuted.m[i][j]) * x[j];
+                // an unknown which underflows is off by a denormal step
+                magnitude += bound[i][j] * (fabs(x[j]) + UNDERFLOW_TERM);
+            }
+            report.kernels[VALIDATE_SOLVE].Add(permutedB[i], residual, magnitude, DECOMPOSITION_TOLERANCE);
+        }
+    }
+
+    void CheckDecompositions(const KernelInputs &in, ValidationReport &report)
+    {
+        const Mat4 matrices[2] = { in.a, in.b };
+        for(int i = 0; i < 2; i++)
+        {
+            const Vec3f &point = in.points[i];
+            CheckLinearSolvers(matrices[i], Point4f(point.x, point.y, point.z, in.time), report);
+
+            // loss of orthogonality of Gram-Schmidt grows with the condition number
+            double condition = ConditionNumber3x3(matrices[i]);
+
+            Mat4 q, r;
+            if(DecomposeQR(matrices[i], q, r))
+            {
+                CheckResidual(report.kernels[VALIDATE_DECOMPOSE_QR], r * q, matrices[i], DECOMPOSITION_TOLERANCE);
+                CheckOrthogonality(report.kernels[VALIDATE_DECOMPOSE_QR], q, true, condition, DECOMPOSITION_TOLERANCE);
+            }
+
+            Mat4 rotation, stretch;
+            if(DecomposePolar(matrices[i], rotation, stretch))
+            {
+                CheckResidual(report.kernels[VALIDATE_DECOMPOSE_POLAR], stretch * rotation, matrices[i], DECOMPOSITION_TOLERANCE);
+                CheckOrthogonality(report.kernels[VALIDATE_DECOMPOSE_POLAR], rotation, false, 1.0, DECOMPOSITION_TOLERANCE);
+            }
+
+            Mat4 symmetric;
+            for(int j = 0; j < 3; j++)
+            {
+                for(int k = 0; k < 3; k++)
+                {
+                    symmetric.m[j][k] = 0.5f * matrices[i].m[j][k] + 0.5f * matrices[i].m[k][j];
+                }
+            }
+            Vec3f eigenvalues;
+            Mat4 eigenvectors;
+            EigenSymmetric3x3(symmetric, eigenvalues, eigenvectors);
+            ErrorStats &eigen = report.kernels[VALIDATE_EIGEN_SYMMETRIC];
+            double norm = FrobeniusNorm3x3(symmetric);
+            for(int j = 0; j < 3; j++)
+            {
+                for(int k = 0; k < 3; k++)
+                {
+                    double product = 0.0;
+                    for(int l = 0; l < 3; l++)
+                    {
+                        product += double(eigenvectors.m[j][l]) * symmetric.m[l][k];
+                    }
+                    eigen.Add(eigenvalues[j] * eigenvectors.m[j][k], product, norm, DECOMPOSITION_TOLERANCE);
+                }
+            }
+            // the solver has no failure result, non-finite inputs are skipped like the residual
+            CheckOrthogonality(eigen, eigenvectors, false, isfinite(norm) ? 1.0 : INFINITY, DECOMPOSITION_TOLERANCE);
+        }
+    }
+
+    /*! Compares frames decoded as a range with frames decoded one at a time. Ten frames give two groups of
+      four for the SSE decoder and a tail of two, single frames always take the scalar path
+      */
+    void CheckTrack(const KernelInputs &in, ValidationReport &report)
+    {
+        const size_t count = 10;
+        Mat4 frames[count];
+        for(size_t f = 0; f < count; f++)
+        {
+            const Mat4 &rows = (f & 1) ? in.b : in.a;
+            const Vec3f &translation = in.points[f % KERNEL_POINT_COUNT];
+            for(int i = 0; i < 3; i++)
+            {
+                for(int j = 0; j < 3; j++)
+                {
+                    frames[f].m[i][j] = rows.m[i][j];
+                }
+                frames[f].m[i][3] = 0.0f;
+            }
+            frames[f].data._41 = translation.x;
+            frames[f].data._42 = translation.y;
+            frames[f].data._43 = translation.z;
+            frames[f].data._44 = 1.0f;
+        }
+
+        ErrorStats &stats = report.kernels[VALIDATE_TRACK_DECODE];
+        CompressedTrack track;
+        try
+        {
+            track.Compress(frames, count);
+        }
+        catch(const exception&)
+        {
+            // zero scale or values out of the quantization range
+            stats.skipped++;
+            return;
+        }
+
+        Mat4 decoded[count];
+        track.Decompress(0, count, decoded);
+        for(size_t f = 0; f < count; f++)
+        {
+            Mat4 single = track.GetFrame(f);
+            CompareExact(stats, decoded[f].m[0], single.m[0], 16);
+        }
+    }
+}
+
+uint32_t MathLib::UlpDistance(float a, float b)
+{
+    if(isnan(a) || isnan(b))
+    {
+        return UINT32_MAX;
+    }
+
+    // map the sign-magnitude representation onto a monotonic unsigned scale
+    uint32_t ua, ub;
+    memcpy(&ua, &a, sizeof(float));
+    memcpy(&ub, &b, sizeof(float));
+    ua = (ua & 0x80000000u) ? ~ua + 1 : ua | 0x80000000u;
+    ub = (ub & 0x80000000u) ? ~ub + 1 : ub | 0x80000000u;
+    return ua > ub ? ua - ub : ub - ua;
+}
+
+double MathLib::UlpError(float actual, double expected)
+{
+    float rounded = fabsf(static_cast<float>(expected));
+    if(isinf(rounded))
+    {
+        rounded = FLT_MAX;
+    }
+    double ulp = double(nextafterf(rounded, INFINITY)) - rounded;
+    return fabs(actual - expected) / ulp;
+}
+
+ErrorStats::ErrorStats()
+    : samples(0), skipped(0), failures(0), maxUlp(0.0), maxRelative(0.0), maxRatio(0.0)
+{
+}
+
+bool ErrorStats::Add(float actual, double expected, double magnitude, double tolerance)
+{
+    // float intermediates may legitimately overflow when the terms leave the float range
+    if(!isfinite(magnitude) || magnitude > FLT_MAX || isnan(expected))
+    {
+        skipped++;
+        return true;
+    }
+
+    samples++;
+    double error = fabs(actual - expected);
+    if(isnan(error))
+    {
+        error = INFINITY;
+    }
+    double ulp = isnan(actual) ? INFINITY : UlpError(actual, expected);
+    maxUlp = ulp > maxUlp ? ulp : maxUlp;
+    // the magnitude floors the denominator, so cancellation to a small expected value does not count as a large error,
+    // and the smallest normal float keeps underflowed results from counting as relative errors of 1
+    double scale = fmax(fmax(fabs(expected), magnitude), double(FLT_MIN));
+    double relative = error / scale;
+    maxRelative = relative > maxRelative ? relative : maxRelative;
+    double allowed = tolerance * magnitude + ABSOLUTE_FLOOR;
+    double ratio = error / allowed;
+    maxRatio = ratio > maxRatio ? ratio : maxRatio;
+
+    if(error > allowed)
+    {
+        failures++;
+        return false;
+    }
+    return true;
+}
+
+bool ErrorStats::AddExact(float actual, float expected)
+{
+    samples++;
+    uint32_t distance = isnan(actual) && isnan(expected) ? 0 : UlpDistance(actual, expected);
+    if(distance == 0 && !isnan(actual) && signbit(actual) != signbit(expected))
+    {
+        // UlpDistance treats both zeroes as equal, the bits differ
+        distance = 1;
+    }
+    maxUlp = distance > maxUlp ? distance : maxUlp;
+    if(distance != 0)
+    {
+        failures++;
+        return false;
+    }
+    return true;
+}
+
+void MathLib::ReferenceMultiply(const Mat4 &a, const Mat4 &b, double result[4][4], bool absolute)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        for(int j = 0; j < 4; j++)
+        {
+            double sum = 0.0;
+            for(int k = 0; k < 4; k++)
+            {
+                sum += Term(double(b.m[i][k]) * a.m[k][j], absolute);
+            }
+            result[i][j] = sum;
+        }
+    }
+}
+
+void MathLib::ReferenceMultiply(const Mat2 &a, const Mat2 &b, double result[2][2], bool absolute)
+{
+    MultiplyNxN<2>(a, b, result, absolute);
+}
+
+void MathLib::ReferenceMultiply(const Mat3 &a, const Mat3 &b, double result[3][3], bool absolute)
+{
+    MultiplyNxN<3>(a, b, result, absolute);
+}
+
+void MathLib::ReferenceTransform(const Mat4 &matrix, const Vec3f &vector, double result[3], bool absolute)
+{
+    for(int j = 0; j < 3; j++)
+    {
+        result[j] = Term(double(vector.x) * matrix.m[j][0], absolute) + Term(double(vector.y) * matrix.m[j][1], absolute) +
+            Term(double(vector.z) * matrix.m[j][2], absolute) + Term(matrix.m[3][j], absolute);
+    }
+}
+
+void MathLib::ReferenceHomogeneous(const Mat4 &matrix, const Vec3f &point, double result[4], bool absolute)
+{
+    for(int j = 0; j < 4; j++)
+    {
+        result[j] = Term(double(point.x) * matrix.m[0][j], absolute) + Term(double(point.y) * matrix.m[1][j], absolute) +
+            Term(double(point.z) * matrix.m[2][j], absolute) + Term(matrix.m[3][j], absolute);
+    }
+}
+
+void MathLib::ReferenceCatmullRom(const Vec3f points[4], float time, double result[3], bool absolute)
+{
+    double t = Term(time, absolute);
+    double t2 = Weight(t * t, absolute);
+    double t3 = Weight(t * t * t, absolute);
+    double sign = absolute ? 1.0 : -1.0;
+    for(int j = 0; j < 3; j++)
+    {
+        double p0 = Term(points[0][j], absolute);
+        double p1 = Term(points[1][j], absolute);
+        double p2 = Term(points[2][j], absolute);
+        double p3 = Term(points[3][j], absolute);
+        double linear = Bounded(sign * p0 + p2, absolute);
+        double square = Bounded(2.0 * p0 + sign * 5.0 * p1 + 4.0 * p2 + sign * p3, absolute);
+        double cube = Bounded(sign * p0 + 3.0 * p1 + sign * 3.0 * p2 + p3, absolute);
+        result[j] = 0.5 * Bounded((2.0 * p1) + linear * t + square * t2 + cube * t3, absolute);
+    }
+}
+
+void MathLib::ReferenceBezier(const Vec3f points[4], float time, double result[3], bool absolute)
+{
+    double t = time;
+    double w0 = Weight(Term((1.0 - t) * (1.0 - t) * t, absolute), absolute);
+    double w1 = Weight(Term(3.0 * t * (1.0 - t) * t, absolute), absolute);
+    double w2 = Weight(Term(3.0 * t * t * (1.0 - t), absolute), absolute);
+    double w3 = Weight(Term(t * t * t, absolute), absolute);
+    for(int j = 0; j < 3; j++)
+    {
+        double sum = w0 * Term(points[0][j], absolute) + w1 * Term(points[1][j], absolute) +
+            w2 * Term(points[2][j], absolute) + w3 * Term(points[3][j], absolute);
+        result[j] = Bounded(sum, absolute);
+    }
+}
+
+void MathLib::ReferenceLinearInterpolation(const Vec3f points[2], float time, double result[3], bool absolute)
+{
+    double t = time;
+    for(int j = 0; j < 3; j++)
+    {
+        result[j] = Bounded(Term(points[0][j] * (1.0 - t), absolute) + Term(points[1][j] * t, absolute), absolute);
+    }
+}
+
+void MathLib::ReferenceNormalMatrix(const Mat4 &matrix, double result[3][3], double magnitude[3][3])
+{
+    double cofactor[3][3], cofactorMagnitude[3][3];
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            // rows of the cofactor matrix are cross products of the other two rows
+            const float *u = matrix.m[(i + 1) % 3];
+            const float *v = matrix.m[(i + 2) % 3];
+            double a = double(u[(j + 1) % 3]) * v[(j + 2) % 3];
+            double b = double(u[(j + 2) % 3]) * v[(j + 1) % 3];
+            cofactor[i][j] = a - b;
+            cofactorMagnitude[i][j] = fabs(a) + fabs(b) + 2.0 * UNDERFLOW_TERM;
+        }
+    }
+
+    double det = 0.0, detMagnitude = 0.0;
+    for(int j = 0; j < 3; j++)
+    {
+        det += matrix.m[0][j] * cofactor[0][j];
+        detMagnitude += fabs(matrix.m[0][j]) * cofactorMagnitude[0][j] + UNDERFLOW_TERM;
+    }
+    DivideCofactors(cofactor[0], cofactorMagnitude[0], 9, det, detMagnitude, result[0], magnitude ? magnitude[0] : 0);
+}
+
+void MathLib::ReferenceInverse(const Mat2 &matrix, double result[2][2], double magnitude[2][2])
+{
+    // the cofactors of a 2x2 matrix are its fields, so only the determinant is rounded
+    const double cofactor[4] = { matrix.m[1][1], -matrix.m[0][1], -matrix.m[1][0], matrix.m[0][0] };
+    const double cofactorMagnitude[4] = { fabs(cofactor[0]), fabs(cofactor[1]), fabs(cofactor[2]), fabs(cofactor[3]) };
+    double a = double(matrix.m[0][0]) * matrix.m[1][1];
+    double b = double(matrix.m[0][1]) * matrix.m[1][0];
+    double detMagnitude = fabs(a) + fabs(b) + 2.0 * UNDERFLOW_TERM;
+    DivideCofactors(cofactor, cofactorMagnitude, 4, a - b, detMagnitude, result[0], magnitude ? magnitude[0] : 0);
+}
+
+void MathLib::ReferenceInverse(const Mat3 &matrix, double result[3][3], double magnitude[3][3])
+{
+    // the inverse is the transposed normal matrix, both expand the determinant along the first row
+    Mat4 full;
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            full.m[i][j] = matrix.m[i][j];
+        }
+    }
+    double normal[3][3], normalMagnitude[3][3];
+    ReferenceNormalMatrix(full, normal, normalMagnitude);
+    for(int i = 0; i < 3; i++)
+    {
+        for(int j = 0; j < 3; j++)
+        {
+            result[i][j] = normal[j][i];
+            if(magnitude)
+            {
+                magnitude[i][j] = normalMagnitude[j][i];
+            }
+        }
+    }
+}
+
+void MathLib::ReferenceInverse(const Affine3x4 &matrix, double result[4][3], double magnitude[4][3])
+{
+    double inverse[3][3], inverseMagnitude[3][3];
+    ReferenceInverse(UpperLeft<3>(matrix.ToMat4()), inverse, inverseMagnitude);
+    for(int j = 0; j < 3; j++)
+    {
+        double translation = 0.0, translationMagnitude = 0.0;
+        for(int k = 0; k < 3; k++)
+        {
+            result[k][j] = inverse[k][j];
+            translation -= matrix.m[3][k] * inverse[k][j];
+            // the float code uses the rounded 3x3 inverse, so its error, underflow included, is scaled by the translation
+            // and a field outside of the float range spoils the translation even when multiplied by 0
+            translationMagnitude += inverseMagnitude[k][j] > FLT_MAX ? INFINITY :
+                fabs(matrix.m[3][k]) * (inverseMagnitude[k][j] + fabs(inverse[k][j]) + UNDERFLOW_TERM) + UNDERFLOW_TERM;
+        }
+        result[3][j] = translation;
+        if(magnitude)
+        {
+            for(int k = 0; k < 3; k++)
+            {
+                magnitude[k][j] = inverseMagnitude[k][j];
+            }
+            magnitude[3][j] = translationMagnitude;
+        }
+    }
+}
+
+void MathLib::ReferencePerspectiveDivide(const Point4f &point, double result[3], double magnitude[3])
+{
+    // the float code multiplies by 1 / w, which loses its precision outside of the normal range
+    double w = point.w;
+    double inverse = fabs(1.0 / w);
+    bool representable = inverse >= FLT_MIN && inverse <= FLT_MAX;
+    for(int j = 0; j < 3; j++)
+    {
+        result[j] = point[j] / w;
+        if(magnitude)
+        {
+            magnitude[j] = representable ? fabs(result[j]) : INFINITY;
+        }
+    }
+}
+
+unsigned char MathLib::ReferenceClipFlags(const Point4f &point)
+{
+    double x = point.x, y = point.y, z = point.z, w = point.w;
+    return (x < -w ? CLIP_LEFT : 0) | (x > w ? CLIP_RIGHT : 0) |
+        (y < -w ? CLIP_BOTTOM : 0) | (y > w ? CLIP_TOP : 0) |
+        (z < 0.0 ? CLIP_NEAR : 0) | (z > w ? CLIP_FAR : 0);
+}
+
+void MathLib::ReferenceBlend(const Color4f &source, const Color4f &destination, double result[4], bool absolute)
+{
+    double alpha = source.a;
+    double inverse = 1.0 - alpha;
+    const float *s = &source.r;
+    const float *d = &destination.r;
+    for(int c = 0; c < 3; c++)
+    {
+        result[c] = Term(s[c] * alpha, absolute) + Term(d[c] * inverse, absolute);
+    }
+    result[3] = Term(alpha, absolute) + Term(d[3] * inverse, absolute);
+}
+
+void MathLib::ReferencePack(const Color4f &color, double result[4], bool srgb)
+{
+    const float *channels = &color.r;
+    for(int c = 0; c < 4; c++)
+    {
+        double value = channels[c];
+        value = value > 0.0 ? (value < 1.0 ? value : 1.0) : 0.0;
+        result[c] = (srgb && c < 3 ? ReferenceLinearToSrgb(value) : value) * 255.0;
+    }
+}
+
+void MathLib::ReferenceUnpack(uint32_t packed, double result[4], bool srgb)
+{
+    for(int c = 0; c < 4; c++)
+    {
+        double value = ((packed >> (8 * c)) & 0xFF) / 255.0;
+        result[c] = srgb && c < 3 ? ReferenceSrgbToLinear(value) : value;
+    }
+}
+
+double MathLib::ReferenceSrgbToLinear(double value)
+{
+    return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+double MathLib::ReferenceLinearToSrgb(double value)
+{
+    return value <= 0.0031308 ? value * 12.92 : 1.055 * pow(value, 1.0 / 2.4) - 0.055;
+}
+
+bool ValidationReport::Passed() const
+{
+    return GetFailures() == 0;
+}
+
+uint64_t ValidationReport::GetFailures() const
+{
+    uint64_t failures = 0;
+    for(int k = 0; k < VALIDATE_KERNEL_COUNT; k++)
+    {
+        failures += kernels[k].failures;
+    }
+    return failures;
+}
+
+uint64_t MathLib::CheckKernels(const KernelInputs &inputs, ValidationReport &report)
+{
+    uint64_t failures = report.GetFailures();
+    CheckArithmetic(inputs, report);
+    CheckMatrices(inputs, report);
+    CheckCurves(inputs, report);
+    CheckNormalMatrices(inputs, report);
+    CheckColors(inputs, report);
+    CheckColorLayouts(inputs, report);
+    CheckDecompositions(inputs, report);
+    CheckTrack(inputs, report);
+    return report.GetFailures() - failures;
+}
+
+void MathLib::CheckSrgbKnees(ValidationReport &report)
+{
+    const float knees[2] = { SRGB_DECODE_KNEE, SRGB_ENCODE_KNEE };
+    for(int k = 0; k < 2; k++)
+    {
+        float value = knees[k];
+        for(int i = 0; i < KNEE_WINDOW; i++)
+        {
+            value = nextafterf(value, 0.0f);
+        }
+        vector<Color4f> colors;
+        for(int i = 0; i <= 2 * KNEE_WINDOW; i++)
+        {
+            colors.push_back(Color4f(value, value, value, 1.0f));
+            value = nextafterf(value, 1.0f);
+        }
+        if(k == 0)
+        {
+            SrgbToLinear(colors.data(), colors.size());
+        }
+        else
+        {
+            LinearToSrgb(colors.data(), colors.size());
+        }
+
+        // an increase compares as equal, a decrease is the error
+        ErrorStats &stats = report.kernels[VALIDATE_SRGB_KNEE_MONOTONIC];
+        for(size_t i = 1; i < colors.size(); i++)
+        {
+            const float *previous = &colors[i - 1].r;
+            const float *current = &colors[i].r;
+            for(int c = 0; c < 3; c++)
+            {
+                stats.Add(current[c], fmax(previous[c], current[c]), 0.0, 0.0);
+            }
+        }
+    }
+}
+
+const char* MathLib::GetValidatedKernelName(ValidatedKernel kernel)
+{
+    return kernel >= 0 && kernel < VALIDATE_KERNEL_COUNT ? KERNEL_NAMES[kernel] : "unknown";
+}
+
+std::string MathLib::ValidationToJson(const ValidationReport &report)
+{
+    ostringstream out;
+    out << "{\"passed\": " << (report.Passed() ? "true" : "false") << ", \"kernels\": {";
+    for(int k = 0; k < VALIDATE_KERNEL_COUNT; k++)
+    {
+        const ErrorStats &stats = report.kernels[k];
+        out << (k > 0 ? ", " : "") << "\"" << KERNEL_NAMES[k] << "\": {"
+            << "\"samples\": " << stats.samples
+            << ", \"skipped\": " << stats.skipped
+            << ", \"failures\": " << stats.failures
+            << ", \"maxUlp\": ";
+        WriteNumber(out, stats.maxUlp);
+        out << ", \"maxRelative\": ";
+        WriteNumber(out, stats.maxRelative);
+        out << ", \"maxRatio\": ";
+        WriteNumber(out, stats.maxRatio);
+        out << "}";
+    }
+    out << "}}";
+    return out.str();
+}
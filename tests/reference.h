@@ -0,0 +1,206 @@
+#ifndef MATH_REFERENCE_H
+#define MATH_REFERENCE_H
+
+#include <string>
+#include <cstddef>
+#include <stdint.h>
+#include "vec.h"
+#include "matrix.h"
+#include "affine.h"
+
+/*! \file reference.h
+  \brief Contains double precision reference kernels and the checks shared by the test drivers.
+  Reference kernels evaluate the same formulas as the scalar code in double precision.
+  A result fails when its error exceeds tolerance * magnitude, where magnitude is the sum
+  of the absolute values of the terms, so cancellation in the input is not blamed on the kernel.
+  sRGB curves are checked relative to the expected value, and the batch curves must not
+  decrease across their knees. Clip flags must match exactly, and Vec4 arithmetic must be
+  correctly rounded. Color planes and Color3f arrays must give the same bits as Color4f arrays,
+  and the SSE track decoder the same bits as the scalar decoder of single frames.
+  Decompositions are checked by their residual relative to the Frobenius norm of the input and
+  by the orthogonality of their orthogonal factor, relative to the condition number for QR.
+  LU and Solve residuals are relative to |L| |U|, the backward error bound of elimination.
+  The drivers are validate_main.cpp and fuzz_kernels.cpp, see tests/README.txt.
+  */
+
+namespace MathLib
+{
+    /*! Returns the distance between two floats in units in the last place, UINT32_MAX if either is NaN */
+    uint32_t UlpDistance(float a, float b);
+
+    /*! Returns the error of a float result in units in the last place of the expected value rounded to float */
+    double UlpError(float actual, double expected);
+
+    //! Error statistics of a single kernel
+    struct ErrorStats
+    {
+        uint64_t samples;	//!< number of compared values
+        uint64_t skipped;	//!< values not compared because the reference is out of float range
+        uint64_t failures;	//!< values outside of the tolerance
+        double maxUlp;	//!< largest error in ULPs
+        double maxRelative;	//!< largest error relative to the largest of the expected value, the magnitude and FLT_MIN
+        double maxRatio;	//!< largest error divided by the allowed error, above 1 for failures
+
+        ErrorStats();
+
+        /*! Compares a result with the reference
+          \param magnitude Sum of the absolute values of the terms of the reference
+          \param tolerance Allowed error relative to the magnitude
+          \return false if the value is outside of the tolerance
+          */
+        bool Add(float actual, double expected, double magnitude, double tolerance);
+
+        /*! Compares a result with the exact expected bits, NaN matches any NaN. Only updates maxUlp of the error fields
+          
+eturn false if the bits differ
+          */
+        bool AddExact(float actual, float expected);
+    };
+
+    /*! Computes a * b the way Mat4::operator * does
+      \param absolute Sums absolute values of the terms instead, giving the magnitude.
+      The magnitude of curves is infinite when a float intermediate would overflow or a weight would underflow
+      */
+    void ReferenceMultiply(const Mat4 &a, const Mat4 &b, double result[4][4], bool absolute = false);
+
+    /*! Computes a * b the way Mat::operator * does for 2x2 matrices */
+    void ReferenceMultiply(const Mat2 &a, const Mat2 &b, double result[2][2], bool absolute = false);
+
+    /*! Computes a * b the way Mat::operator * does for 3x3 matrices */
+    void ReferenceMultiply(const Mat3 &a, const Mat3 &b, double result[3][3], bool absolute = false);
+
+    /*! Computes Vec3::Transform */
+    void ReferenceTransform(const Mat4 &matrix, const Vec3f &vector, double result[3], bool absolute = false);
+
+    /*! Computes TransformHomogeneous */
+    void ReferenceHomogeneous(const Mat4 &matrix, const Vec3f &point, double result[4], bool absolute = false);
+
+    /*! Computes CatmullRom between points[1] and points[2] */
+    void ReferenceCatmullRom(const Vec3f points[4], float time, double result[3], bool absolute = false);
+
+    /*! Computes Bezier, following the weights used by the scalar code */
+    void ReferenceBezier(const Vec3f points[4], float time, double result[3], bool absolute = false);
+
+    /*! Computes LinearInterpolation between points[0] and points[1] */
+    void ReferenceLinearInterpolation(const Vec3f points[2], float time, double result[3], bool absolute = false);
+
+    /*! Computes NormalMatrix
+      \param magnitude Receives the first order error bound of every field divided by the machine epsilon, may be null.
+      Infinite when the determinant leaves the normal float range or is dominated by rounding errors
+      */
+    void ReferenceNormalMatrix(const Mat4 &matrix, double result[3][3], double magnitude[3][3] = 0);
+
+    /*! Computes Mat2::Inverted, magnitude as in ReferenceNormalMatrix */
+    void ReferenceInverse(const Mat2 &matrix, double result[2][2], double magnitude[2][2] = 0);
+
+    /*! Computes Mat3::Inverted, magnitude as in ReferenceNormalMatrix */
+    void ReferenceInverse(const Mat3 &matrix, double result[3][3], double magnitude[3][3] = 0);
+
+    /*! Computes Affine3x4::Inverted, magnitude as in ReferenceNormalMatrix */
+    void ReferenceInverse(const Affine3x4 &matrix, double result[4][3], double magnitude[4][3] = 0);
+
+    /*! Computes PerspectiveDivide of one point, the magnitude is infinite when 1 / w is not a normal float */
+    void ReferencePerspectiveDivide(const Point4f &point, double result[3], double magnitude[3] = 0);
+
+    /*! Computes ClipFlags of a clip space point */
+    unsigned char ReferenceClipFlags(const Point4f &point);
+
+    /*! Computes BlendColors of one pair of colors */
+    void ReferenceBlend(const Color4f &source, const Color4f &destination, double result[4], bool absolute = false);
+
+    /*! Computes the channels of PackRGBA8 before rounding, scaled to [0, 255], NaN gives 0 */
+    void ReferencePack(const Color4f &color, double result[4], bool srgb = false);
+
+    /*! Computes the channels of UnpackRGBA8 */
+    void ReferenceUnpack(uint32_t packed, double result[4], bool srgb = false);
+
+    /*! Converts sRGB to linear with the exact curve */
+    double ReferenceSrgbToLinear(double value);
+
+    /*! Converts linear to sRGB with the exact curve */
+    double ReferenceLinearToSrgb(double value);
+
+    /*! Kernels checked against the reference */
+    enum ValidatedKernel
+    {
+        VALIDATE_MAT4_MULTIPLY,
+        VALIDATE_VEC3_TRANSFORM,
+        VALIDATE_VEC4_DOT,
+        VALIDATE_VEC4_ARITHMETIC,
+        VALIDATE_AFFINE_TRANSFORM_BATCH,
+        VALIDATE_HOMOGENEOUS_TRANSFORM_BATCH,
+        VALIDATE_PERSPECTIVE_DIVIDE_BATCH,
+        VALIDATE_CLIP_FLAGS_BATCH,
+        VALIDATE_AFFINE_MULTIPLY,
+        VALIDATE_AFFINE_INVERSE,
+        VALIDATE_MAT2_MULTIPLY,
+        VALIDATE_MAT2_INVERSE,
+        VALIDATE_MAT3_MULTIPLY,
+        VALIDATE_MAT3_INVERSE,
+        VALIDATE_CATMULL_ROM,
+        VALIDATE_BEZIER,
+        VALIDATE_LINEAR_INTERPOLATION,
+        VALIDATE_NORMAL_MATRIX_BATCH,
+        VALIDATE_SRGB_DECODE_BATCH,
+        VALIDATE_SRGB_ENCODE_BATCH,
+        VALIDATE_SRGB_KNEE_MONOTONIC,
+        VALIDATE_BLEND_BATCH,
+        VALIDATE_MULTIPLY_ADD_COLORS_BATCH,
+        VALIDATE_CLAMP_COLORS_BATCH,
+        VALIDATE_PACK_RGBA8_BATCH,
+        VALIDATE_PACK_RGBA8_SRGB_BATCH,
+        VALIDATE_UNPACK_RGBA8_BATCH,
+        VALIDATE_COLOR_PLANES,
+        VALIDATE_COLOR3_BATCH,
+        VALIDATE_DECOMPOSE_LU,
+        VALIDATE_SOLVE,
+        VALIDATE_DECOMPOSE_QR,
+        VALIDATE_DECOMPOSE_POLAR,
+        VALIDATE_EIGEN_SYMMETRIC,
+        VALIDATE_TRACK_DECODE,
+        VALIDATE_KERNEL_COUNT
+    };
+
+    /*! Results of a validation run */
+    struct ValidationReport
+    {
+        ErrorStats kernels[VALIDATE_KERNEL_COUNT];
+
+        /*! Returns true if no kernel has failures */
+        bool Passed() const;
+
+        /*! Returns the total number of failures */
+        uint64_t GetFailures() const;
+    };
+
+    /*! Number of points in KernelInputs */
+    const size_t KERNEL_POINT_COUNT = 4;
+
+    //! Inputs shared by all checks of one iteration
+    struct KernelInputs
+    {
+        Mat4 a;
+        Mat4 b;
+        Vec3f points[KERNEL_POINT_COUNT];
+        float time;	//!< curve parameter
+        float units[KERNEL_POINT_COUNT];	//!< color channels, expected in [0, 1]
+    };
+
+    /*! Runs every kernel on one set of inputs, accumulating into report
+      \return number of failures caused by these inputs
+      */
+    uint64_t CheckKernels(const KernelInputs &inputs, ValidationReport &report);
+
+    /*! Runs the batch sRGB curves over every float within a window around their knees
+      and counts every decrease as a failure of VALIDATE_SRGB_KNEE_MONOTONIC
+      */
+    void CheckSrgbKnees(ValidationReport &report);
+
+    /*! Returns a short snake_case name of a kernel */
+    const char* GetValidatedKernelName(ValidatedKernel kernel);
+
+    /*! Writes a report as a JSON object */
+    std::string ValidationToJson(const ValidationReport &report);
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*! \file validate_main.cpp
+  \brief Runs every kernel on randomized and adversarial inputs and compares it with the reference.
+  Prints a JSON report and exits with 1 when any kernel is outside of its tolerance:
+  \code
+  g++ -std=c++17 -O2 -Isrc -Itests src/[a-z]*.cpp tests/reference.cpp tests/validate_main.cpp -o validate -pthread
+  ./validate [iterations] [seed]
+  \endcode
+  Usage and the other builds are described in tests/README.txt.
+  */
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdint.h>
+#include "reference.h"
+
+using namespace MathLib;
+using namespace std;
+
+namespace
+{
+    const size_t DEFAULT_ITERATIONS = 2000;
+
+    /*! Classes of generated inputs */
+    enum InputClass
+    {
+        INPUT_UNIFORM,	//!< values in [-100, 100]
+        INPUT_DENORMAL,	//!< denormal values of both signs
+        INPUT_HUGE,	//!< magnitudes between 2^40 and 2^62
+        INPUT_TINY,	//!< normal magnitudes between 2^-126 and 2^-100
+        INPUT_NEAR_SINGULAR,	//!< uniform values, matrices get a nearly dependent third row
+        INPUT_MIXED,	//!< every value picks a class, zeroes and ones included
+        INPUT_CLASS_COUNT
+    };
+
+    //! Seeded generator of randomized and adversarial inputs
+    class InputGenerator
+    {
+        public:
+            /*! Creates a generator, equal seeds give equal sequences */
+            explicit InputGenerator(uint32_t seed);
+
+            /*! Returns a value of the given class */
+            float NextFloat(InputClass inputClass);
+
+            /*! Returns a value in [0, 1], including the end points and denormals */
+            float NextUnit();
+
+            /*! Returns a vector of the given class */
+            Vec3f NextVec3(InputClass inputClass);
+
+            /*! Returns a matrix of the given class */
+            Mat4 NextMat4(InputClass inputClass);
+
+        private:
+            mt19937 engine;
+    };
+
+    InputGenerator::InputGenerator(uint32_t seed)
+        : engine(seed)
+    {
+    }
+
+    float InputGenerator::NextFloat(InputClass inputClass)
+    {
+        uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+        float sign = (engine() & 1) ? -1.0f : 1.0f;
+        switch(inputClass)
+        {
+            case INPUT_DENORMAL:
+            {
+                uint32_t bits = (engine() & 0x007FFFFFu) | 1u;
+                float value;
+                memcpy(&value, &bits, sizeof(float));
+                return sign * value;
+            }
+            case INPUT_HUGE:
+                return sign * ldexpf(1.0f + fabsf(uniform(engine)), 40 + engine() % 23);
+            case INPUT_TINY:
+                return sign * ldexpf(1.0f + fabsf(uniform(engine)), -126 + static_cast<int>(engine() % 27));
+            case INPUT_MIXED:
+            {
+                uint32_t choice = engine() % 7;
+                if(choice == 5)
+                {
+                    return 0.0f;
+                }
+                if(choice == 6)
+                {
+                    return sign;
+                }
+                return NextFloat(static_cast<InputClass>(choice));
+            }
+            default:
+                return 100.0f * uniform(engine);
+        }
+    }
+
+    float InputGenerator::NextUnit()
+    {
+        switch(engine() % 8)
+        {
+            case 0:
+                return 0.0f;
+            case 1:
+                return 1.0f;
+            case 2:
+                return fabsf(NextFloat(INPUT_DENORMAL));
+            case 3:
+                return 1.0f - FLT_EPSILON / 2.0f;
+            default:
+                return uniform_real_distribution<float>(0.0f, 1.0f)(engine);
+        }
+    }
+
+    Vec3f InputGenerator::NextVec3(InputClass inputClass)
+    {
+        float x = NextFloat(inputClass);
+        float y = NextFloat(inputClass);
+        float z = NextFloat(inputClass);
+        return Vec3f(x, y, z);
+    }
+
+    Mat4 InputGenerator::NextMat4(InputClass inputClass)
+    {
+        Mat4 matrix;
+        for(int i = 0; i < 16; i++)
+        {
+            matrix.m[i / 4][i % 4] = NextFloat(inputClass);
+        }
+
+        if(inputClass == INPUT_NEAR_SINGULAR)
+        {
+            uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+            float a = uniform(engine);
+            float b = uniform(engine);
+            for(int j = 0; j < 4; j++)
+            {
+                matrix.m[2][j] = a * matrix.m[0][j] + b * matrix.m[1][j] + 1e-4f * uniform(engine);
+            }
+        }
+        return matrix;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t iterations = argc > 1 ? strtoul(argv[1], 0, 10) : DEFAULT_ITERATIONS;
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], 0, 10)) : 1;
+
+    ValidationReport report;
+    CheckSrgbKnees(report);
+
+    InputGenerator generator(seed);
+    KernelInputs in;
+    for(size_t i = 0; i < iterations; i++)
+    {
+        for(int c = 0; c < INPUT_CLASS_COUNT; c++)
+        {
+            InputClass inputClass = static_cast<InputClass>(c);
+            in.a = generator.NextMat4(inputClass);
+            in.b = generator.NextMat4(inputClass);
+            for(size_t p = 0; p < KERNEL_POINT_COUNT; p++)
+            {
+                in.points[p] = generator.NextVec3(inputClass);
+                in.units[p] = generator.NextUnit();
+            }
+            in.time = generator.NextUnit();
+            CheckKernels(in, report);
+        }
+    }
+
+    printf("%s\n", ValidationToJson(report).c_str());
+    return report.Passed() ? 0 : 1;
+}